@@ -0,0 +1,446 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "search_workspace.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Целенаправленный поиск A*: очередь упорядочена по сумме пройденного веса и нижней оценки
+// остатка пути до цели. Оценка - максимум из внешней (например, географической) и оценок ALT
+// по неравенству треугольника относительно ориентиров с заранее посчитанными расстояниями.
+// Оценки должны быть допустимыми (не больше истинного веса), тогда маршрут совпадает с Дейкстрой;
+// вершины переоткрываются при улучшении, поэтому погрешность округления в оценках не теряет маршрут.
+template <typename Weight>
+class AStarRouter : public RouterBase<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+    using Endpoint = typename RouterBase<Weight>::Endpoint;
+    using BestRouteInfo = typename RouterBase<Weight>::BestRouteInfo;
+    // Нижняя оценка веса пути между вершинами; пустая функция - оценка не используется
+    using LowerBound = std::function<Weight(VertexId from, VertexId to)>;
+
+    static constexpr Weight NO_DISTANCE = std::numeric_limits<Weight>::infinity();
+
+    AStarRouter(const Graph& graph, LowerBound lower_bound, size_t landmark_count);
+    // distances_from_landmarks[v * landmarks.size() + i] - вес пути от i-го ориентира до v,
+    // distances_to_landmarks - от v до ориентира; NO_DISTANCE - пути нет
+    AStarRouter(const Graph& graph, LowerBound lower_bound, std::vector<VertexId> landmarks,
+                std::vector<Weight> distances_from_landmarks, std::vector<Weight> distances_to_landmarks);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    std::optional<Weight> BuildRouteInto(VertexId from, VertexId to, std::vector<EdgeId>& edges) const override;
+    // Один поиск сразу из всех источников с начальными весами-добавками. Оценка остатка пути -
+    // минимум по целям из оценки до цели плюс её добавка, она остаётся допустимой
+    std::optional<BestRouteInfo> BuildBestRoute(const std::vector<Endpoint>& sources,
+                                                const std::vector<Endpoint>& targets,
+                                                std::vector<EdgeId>& edges) const override;
+
+    const std::vector<VertexId>& GetLandmarks() const;
+    const std::vector<Weight>& GetDistancesFromLandmarks() const;
+    const std::vector<Weight>& GetDistancesToLandmarks() const;
+
+private:
+    void CheckWeights() const;
+    std::vector<Weight> ComputeDistances(const CompressedGraph<Weight>& graph, VertexId from) const;
+    void SelectLandmarks(size_t landmark_count);
+    Weight GetLowerBound(VertexId vertex, VertexId to) const;
+    Weight GetLowerBound(VertexId vertex, const std::vector<Endpoint>& targets) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+    CompressedGraph<Weight> compressed_graph_;
+    LowerBound lower_bound_;
+
+    std::vector<VertexId> landmarks_;
+    std::vector<Weight> distances_from_landmarks_;
+    std::vector<Weight> distances_to_landmarks_;
+};
+
+template <typename Weight>
+AStarRouter<Weight>::AStarRouter(const Graph& graph, LowerBound lower_bound, size_t landmark_count)
+    : graph_(graph)
+    , compressed_graph_(graph)
+    , lower_bound_(std::move(lower_bound))
+{
+    CheckWeights();
+    SelectLandmarks(landmark_count);
+}
+
+template <typename Weight>
+AStarRouter<Weight>::AStarRouter(const Graph& graph, LowerBound lower_bound, std::vector<VertexId> landmarks,
+                                 std::vector<Weight> distances_from_landmarks,
+                                 std::vector<Weight> distances_to_landmarks)
+    : graph_(graph)
+    , compressed_graph_(graph)
+    , lower_bound_(std::move(lower_bound))
+    , landmarks_(std::move(landmarks))
+    , distances_from_landmarks_(std::move(distances_from_landmarks))
+    , distances_to_landmarks_(std::move(distances_to_landmarks))
+{
+    CheckWeights();
+    const size_t table_size = graph.GetVertexCount() * landmarks_.size();
+    if (distances_from_landmarks_.size() != table_size || distances_to_landmarks_.size() != table_size) {
+        throw std::invalid_argument("Landmarks data doesn't match the graph");
+    }
+    for (const VertexId landmark : landmarks_) {
+        if (landmark >= graph.GetVertexCount()) {
+            throw std::invalid_argument("Landmarks data doesn't match the graph");
+        }
+    }
+}
+
+template <typename Weight>
+const std::vector<VertexId>& AStarRouter<Weight>::GetLandmarks() const {
+    return landmarks_;
+}
+
+template <typename Weight>
+const std::vector<Weight>& AStarRouter<Weight>::GetDistancesFromLandmarks() const {
+    return distances_from_landmarks_;
+}
+
+template <typename Weight>
+const std::vector<Weight>& AStarRouter<Weight>::GetDistancesToLandmarks() const {
+    return distances_to_landmarks_;
+}
+
+template <typename Weight>
+void AStarRouter<Weight>::CheckWeights() const {
+    const size_t edge_count = graph_.GetEdgeCount();
+    for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+        if (graph_.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+}
+
+template <typename Weight>
+std::vector<Weight> AStarRouter<Weight>::ComputeDistances(const CompressedGraph<Weight>& graph,
+                                                          VertexId from) const {
+    std::vector<Weight> distances(graph.GetVertexCount(), NO_DISTANCE);
+    std::priority_queue<std::pair<Weight, VertexId>, std::vector<std::pair<Weight, VertexId>>,
+                        std::greater<std::pair<Weight, VertexId>>> queue;
+    distances[from] = ZERO_WEIGHT;
+    queue.push({ZERO_WEIGHT, from});
+
+    while (!queue.empty()) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (distances[vertex] < weight) {
+            continue;
+        }
+
+        const size_t edges_end = graph.GetFirstEdge(vertex + 1);
+        for (size_t position = graph.GetFirstEdge(vertex); position < edges_end; ++position) {
+            const VertexId target = graph.GetEdgeTarget(position);
+            const Weight candidate_weight = weight + graph.GetEdgeWeight(position);
+            if (candidate_weight < distances[target]) {
+                distances[target] = candidate_weight;
+                queue.push({candidate_weight, target});
+            }
+        }
+    }
+
+    return distances;
+}
+
+template <typename Weight>
+void AStarRouter<Weight>::SelectLandmarks(size_t landmark_count) {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (landmark_count == 0) {
+        return;
+    }
+
+    std::vector<std::pair<EdgeId, Edge<Weight>>> reversed_edges;
+    reversed_edges.reserve(graph_.GetEdgeCount());
+    std::vector<bool> has_edges(vertex_count, false);
+    for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph_.GetEdge(edge_id);
+        reversed_edges.push_back({edge_id, {edge.to, edge.from, edge.weight}});
+        has_edges[edge.from] = has_edges[edge.to] = true;
+    }
+    const CompressedGraph<Weight> reversed_graph(vertex_count, reversed_edges);
+
+    const auto first_vertex = std::find(has_edges.begin(), has_edges.end(), true);
+    if (first_vertex == has_edges.end()) {
+        return;
+    }
+
+    // Выбор "самых дальних": очередной ориентир - вершина с наибольшим расстоянием туда и
+    // обратно до ближайшего из уже выбранных. Вершины, недостижимые из выбранных, берутся первыми
+    std::vector<Weight> coverage(vertex_count, NO_DISTANCE);
+    const auto update_coverage = [&](const std::vector<Weight>& from, const std::vector<Weight>& to) {
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            coverage[vertex] = std::min(coverage[vertex], from[vertex] + to[vertex]);
+        }
+    };
+    const VertexId seed = static_cast<VertexId>(first_vertex - has_edges.begin());
+    update_coverage(ComputeDistances(compressed_graph_, seed), ComputeDistances(reversed_graph, seed));
+
+    std::vector<std::vector<Weight>> distances_from;
+    std::vector<std::vector<Weight>> distances_to;
+    while (landmarks_.size() < landmark_count) {
+        std::optional<VertexId> best_vertex;
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            if (has_edges[vertex] && coverage[vertex] > ZERO_WEIGHT &&
+                (!best_vertex || coverage[*best_vertex] < coverage[vertex])) {
+                best_vertex = vertex;
+            }
+        }
+        if (!best_vertex) {
+            break;
+        }
+
+        landmarks_.push_back(*best_vertex);
+        distances_from.push_back(ComputeDistances(compressed_graph_, *best_vertex));
+        distances_to.push_back(ComputeDistances(reversed_graph, *best_vertex));
+        update_coverage(distances_from.back(), distances_to.back());
+        coverage[*best_vertex] = ZERO_WEIGHT;
+    }
+
+    // Расстояния одной вершины до всех ориентиров лежат рядом, чтобы оценка читала одну строку
+    const size_t landmarks_count = landmarks_.size();
+    distances_from_landmarks_.resize(vertex_count * landmarks_count);
+    distances_to_landmarks_.resize(vertex_count * landmarks_count);
+    for (size_t i = 0; i < landmarks_count; ++i) {
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            distances_from_landmarks_[vertex * landmarks_count + i] = distances_from[i][vertex];
+            distances_to_landmarks_[vertex * landmarks_count + i] = distances_to[i][vertex];
+        }
+    }
+}
+
+template <typename Weight>
+Weight AStarRouter<Weight>::GetLowerBound(VertexId vertex, VertexId to) const {
+    Weight bound = lower_bound_ ? lower_bound_(vertex, to) : ZERO_WEIGHT;
+
+    // d(L, to) - d(L, v) <= d(v, to) и d(v, L) - d(to, L) <= d(v, to); бесконечные слагаемые оценки не дают
+    const size_t landmarks_count = landmarks_.size();
+    const Weight* from_vertex = distances_from_landmarks_.data() + vertex * landmarks_count;
+    const Weight* from_to = distances_from_landmarks_.data() + to * landmarks_count;
+    const Weight* to_vertex = distances_to_landmarks_.data() + vertex * landmarks_count;
+    const Weight* to_to = distances_to_landmarks_.data() + to * landmarks_count;
+    for (size_t i = 0; i < landmarks_count; ++i) {
+        if (from_to[i] != NO_DISTANCE && from_vertex[i] != NO_DISTANCE) {
+            bound = std::max(bound, from_to[i] - from_vertex[i]);
+        }
+        if (to_vertex[i] != NO_DISTANCE && to_to[i] != NO_DISTANCE) {
+            bound = std::max(bound, to_vertex[i] - to_to[i]);
+        }
+    }
+    return bound;
+}
+
+template <typename Weight>
+Weight AStarRouter<Weight>::GetLowerBound(VertexId vertex, const std::vector<Endpoint>& targets) const {
+    Weight bound = NO_DISTANCE;
+    for (const auto& [target, extra_weight] : targets) {
+        bound = std::min(bound, GetLowerBound(vertex, target) + extra_weight);
+    }
+    return bound;
+}
+
+template <typename Weight>
+std::optional<Weight> AStarRouter<Weight>::BuildRouteInto(VertexId from, VertexId to,
+                                                          std::vector<EdgeId>& edges) const {
+    using Workspace = SearchWorkspace<Weight>;
+
+    const size_t vertex_count = compressed_graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    auto& workspace = GetThreadWorkspace<Weight>();
+    workspace.Reset(vertex_count);
+    auto& queue = workspace.queue;
+    SearchStats* const stats = GetThreadSearchStats();
+    workspace.Reach(from, ZERO_WEIGHT, Workspace::NO_EDGE);
+    queue.push_back({GetLowerBound(from, to), ZERO_WEIGHT, from});
+    if (stats) {
+        ++stats->heap_pushes;
+    }
+
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end(), std::greater<typename Workspace::QueueItem>());
+        const auto [key, weight, vertex] = queue.back();
+        queue.pop_back();
+        if (stats) {
+            ++stats->heap_pops;
+        }
+        if (workspace.GetWeight(vertex) < weight) {
+            continue;
+        }
+        if (stats) {
+            ++stats->settled_vertices;
+        }
+        if (vertex == to) {
+            break;
+        }
+
+        const size_t edges_begin = compressed_graph_.GetFirstEdge(vertex);
+        const size_t edges_end = compressed_graph_.GetFirstEdge(vertex + 1);
+        if (stats) {
+            stats->relaxed_edges += edges_end - edges_begin;
+        }
+        for (size_t position = edges_begin; position < edges_end; ++position) {
+            const VertexId target = compressed_graph_.GetEdgeTarget(position);
+            const Weight candidate_weight = weight + compressed_graph_.GetEdgeWeight(position);
+            if (!workspace.IsReached(target) || candidate_weight < workspace.GetWeight(target)) {
+                workspace.Reach(target, candidate_weight, compressed_graph_.GetEdgeId(position));
+                queue.push_back({candidate_weight + GetLowerBound(target, to), candidate_weight, target});
+                std::push_heap(queue.begin(), queue.end(), std::greater<typename Workspace::QueueItem>());
+                if (stats) {
+                    ++stats->heap_pushes;
+                }
+            }
+        }
+    }
+    MarkSearchFinished(stats);
+
+    edges.clear();
+    if (!workspace.IsReached(to)) {
+        return std::nullopt;
+    }
+
+    for (EdgeId edge_id = workspace.GetPrevEdge(to);
+         edge_id != Workspace::NO_EDGE;
+         edge_id = workspace.GetPrevEdge(graph_.GetEdge(edge_id).from))
+    {
+        edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return workspace.GetWeight(to);
+}
+
+template <typename Weight>
+std::optional<typename AStarRouter<Weight>::RouteInfo> AStarRouter<Weight>::BuildRoute(
+    VertexId from, VertexId to) const {
+    RouteInfo route;
+    const auto weight = BuildRouteInto(from, to, route.edges);
+    if (!weight) {
+        return std::nullopt;
+    }
+    route.weight = *weight;
+    return route;
+}
+
+template <typename Weight>
+std::optional<typename AStarRouter<Weight>::BestRouteInfo> AStarRouter<Weight>::BuildBestRoute(
+    const std::vector<Endpoint>& sources, const std::vector<Endpoint>& targets, std::vector<EdgeId>& edges) const {
+    using Workspace = SearchWorkspace<Weight>;
+
+    edges.clear();
+    const size_t vertex_count = compressed_graph_.GetVertexCount();
+    for (const auto& endpoints : {&sources, &targets}) {
+        for (const Endpoint& endpoint : *endpoints) {
+            if (endpoint.vertex >= vertex_count) {
+                throw std::out_of_range("Vertex id is out of range");
+            }
+        }
+    }
+
+    auto& workspace = GetThreadWorkspace<Weight>();
+    workspace.Reset(vertex_count);
+    auto& queue = workspace.queue;
+    SearchStats* const stats = GetThreadSearchStats();
+    const auto push = [&](Weight weight, VertexId vertex) {
+        queue.push_back({weight + GetLowerBound(vertex, targets), weight, vertex});
+        std::push_heap(queue.begin(), queue.end(), std::greater<typename Workspace::QueueItem>());
+        if (stats) {
+            ++stats->heap_pushes;
+        }
+    };
+
+    for (const auto& [vertex, extra_weight] : sources) {
+        if (!workspace.IsReached(vertex) || extra_weight < workspace.GetWeight(vertex)) {
+            workspace.Reach(vertex, extra_weight, Workspace::NO_EDGE);
+            push(extra_weight, vertex);
+        }
+    }
+    for (const Endpoint& target : targets) {
+        workspace.MarkTarget(target.vertex);
+    }
+
+    // Ключ - нижняя оценка итога любого маршрута через вершину, поэтому поиск заканчивается,
+    // когда наименьший ключ в очереди не меньше лучшего найденного итога
+    std::optional<BestRouteInfo> best;
+    VertexId best_vertex = 0;
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end(), std::greater<typename Workspace::QueueItem>());
+        const auto [key, weight, vertex] = queue.back();
+        queue.pop_back();
+        if (stats) {
+            ++stats->heap_pops;
+        }
+        if (best && !(key < best->weight)) {
+            break;
+        }
+        if (workspace.GetWeight(vertex) < weight) {
+            continue;
+        }
+        if (stats) {
+            ++stats->settled_vertices;
+        }
+        if (workspace.IsTarget(vertex)) {
+            for (size_t target_index = 0; target_index < targets.size(); ++target_index) {
+                const Weight total_weight = weight + targets[target_index].extra_weight;
+                if (targets[target_index].vertex == vertex && (!best || total_weight < best->weight)) {
+                    best = BestRouteInfo{total_weight, 0, target_index};
+                    best_vertex = vertex;
+                }
+            }
+        }
+
+        const size_t edges_begin = compressed_graph_.GetFirstEdge(vertex);
+        const size_t edges_end = compressed_graph_.GetFirstEdge(vertex + 1);
+        if (stats) {
+            stats->relaxed_edges += edges_end - edges_begin;
+        }
+        for (size_t position = edges_begin; position < edges_end; ++position) {
+            const VertexId target = compressed_graph_.GetEdgeTarget(position);
+            const Weight candidate_weight = weight + compressed_graph_.GetEdgeWeight(position);
+            if (!workspace.IsReached(target) || candidate_weight < workspace.GetWeight(target)) {
+                workspace.Reach(target, candidate_weight, compressed_graph_.GetEdgeId(position));
+                push(candidate_weight, target);
+            }
+        }
+    }
+    MarkSearchFinished(stats);
+    if (!best) {
+        return std::nullopt;
+    }
+
+    VertexId root = best_vertex;
+    for (EdgeId edge_id = workspace.GetPrevEdge(root); edge_id != Workspace::NO_EDGE;
+         edge_id = workspace.GetPrevEdge(root)) {
+        edges.push_back(edge_id);
+        root = graph_.GetEdge(edge_id).from;
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    // Корень пути - источник, с добавкой которого он был достигнут
+    for (size_t source_index = 0; source_index < sources.size(); ++source_index) {
+        if (sources[source_index].vertex == root
+            && !(workspace.GetWeight(root) < sources[source_index].extra_weight)) {
+            best->source_index = source_index;
+            break;
+        }
+    }
+    return best;
+}
+
+}  // namespace graph
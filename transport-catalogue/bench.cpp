@@ -0,0 +1,600 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#ifdef __unix__
+#include <unistd.h>
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "geo.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+using namespace std;
+using namespace transport_catalogue;
+
+// Сравнение маршрутизаторов на синтетических сетях: grid - остановки в узлах решётки,
+// автобусы идут случайными путями по соседним узлам; radial - лучи из центра и кольца,
+// автобусы ходят вдоль лучей (часть - через центр) и по дугам колец. При shuffle-stops остановки
+// попадают в справочник в случайном порядке, как в реальных запросах, а не по соседству
+struct BenchOptions {
+    string layout = "grid"s;
+    size_t stops = 400;
+    size_t buses = 100;
+    size_t min_route_stops = 5;
+    size_t max_route_stops = 25;
+    size_t queries = 1000;
+    uint32_t seed = 42;
+    double bus_velocity = 40;
+    double bus_wait_time = 6;
+    bool shuffle_stops = false;
+    string vertex_order = "catalogue"s;
+    // Потоки, одновременно отвечающие на запросы маршрутов
+    size_t threads = 1;
+    // Сверять ответы каждого маршрутизатора с all_pairs: общее время и списки элементов
+    bool check = false;
+    vector<string> routers{"all_pairs"s, "all_pairs_dijkstra"s, "all_pairs_compact"s, "dijkstra"s,
+                           "contraction_hierarchies"s, "tree_cache"s, "raptor"s, "astar"s, "alt"s,
+                           "hub_labels"s};
+};
+
+void PrintUsage(std::ostream& stream = std::cerr) {
+    stream << "Usage: transport_catalogue_bench [--layout=grid|radial] [--stops=N] [--buses=N]\n"
+              "       [--min-route-stops=N] [--max-route-stops=N] [--queries=N] [--seed=N]\n"
+              "       [--bus-velocity=X] [--bus-wait-time=X] [--shuffle-stops=0|1]\n"
+              "       [--vertex-order=catalogue|rcm|hilbert] [--threads=N] [--check=0|1]\n"
+              "       [--routers=name,name,...]\n"sv;
+}
+
+vector<string> SplitList(const string& list) {
+    vector<string> res;
+    istringstream stream(list);
+    for (string item; getline(stream, item, ',');) {
+        if (!item.empty()) {
+            res.push_back(item);
+        }
+    }
+    return res;
+}
+
+bool ParseOptions(int argc, char* argv[], BenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        const string_view arg(argv[i]);
+        const size_t equal_pos = arg.find('=');
+        if (arg.substr(0, 2) != "--"sv || equal_pos == string_view::npos) {
+            return false;
+        }
+        const string_view key = arg.substr(2, equal_pos - 2);
+        const string value(arg.substr(equal_pos + 1));
+
+        if (key == "layout"sv) {
+            options.layout = value;
+        } else if (key == "stops"sv) {
+            options.stops = stoul(value);
+        } else if (key == "buses"sv) {
+            options.buses = stoul(value);
+        } else if (key == "min-route-stops"sv) {
+            options.min_route_stops = stoul(value);
+        } else if (key == "max-route-stops"sv) {
+            options.max_route_stops = stoul(value);
+        } else if (key == "queries"sv) {
+            options.queries = stoul(value);
+        } else if (key == "seed"sv) {
+            options.seed = static_cast<uint32_t>(stoul(value));
+        } else if (key == "bus-velocity"sv) {
+            options.bus_velocity = stod(value);
+        } else if (key == "bus-wait-time"sv) {
+            options.bus_wait_time = stod(value);
+        } else if (key == "shuffle-stops"sv) {
+            options.shuffle_stops = value == "1"sv;
+        } else if (key == "vertex-order"sv) {
+            router::ParseVertexOrder(value);
+            options.vertex_order = value;
+        } else if (key == "threads"sv) {
+            options.threads = stoul(value);
+        } else if (key == "check"sv) {
+            options.check = value == "1"sv;
+        } else if (key == "routers"sv) {
+            options.routers = SplitList(value);
+        } else {
+            return false;
+        }
+    }
+    return (options.layout == "grid"sv || options.layout == "radial"sv) && options.stops >= 2 &&
+           options.min_route_stops >= 2 && options.min_route_stops <= options.max_route_stops && options.threads >= 1;
+}
+
+class NetworkGenerator {
+public:
+    NetworkGenerator(TransportCatalogue& db, const BenchOptions& options)
+        : db_(db), options_(options), random_(options.seed) {}
+
+    void Generate() {
+        if (options_.layout == "radial"sv) {
+            GenerateRadial();
+        } else {
+            GenerateGrid();
+        }
+
+        vector<size_t> stops_order(stop_names_.size());
+        iota(stops_order.begin(), stops_order.end(), 0);
+        if (options_.shuffle_stops) {
+            shuffle(stops_order.begin(), stops_order.end(), random_);
+        }
+        for (const size_t stop : stops_order) {
+            db_.AddStop(stop_names_[stop], coordinates_[stop]);
+        }
+
+        for (const auto& [stop_name, distances] : distances_) {
+            vector<pair<string_view, double>> stop_distances;
+            for (const auto& [to_name, distance] : distances) {
+                stop_distances.push_back({to_name, distance});
+            }
+            db_.AddStopDistances(stop_name, stop_distances);
+        }
+        for (size_t i = 0; i < bus_routes_.size(); ++i) {
+            const auto& [route, is_roundtrip] = bus_routes_[i];
+            vector<string_view> route_names;
+            for (const size_t stop : route) {
+                route_names.push_back(stop_names_[stop]);
+            }
+            db_.AddBus("Bus "s + to_string(i), route_names, is_roundtrip);
+        }
+    }
+
+private:
+    void AddStop(double latitude, double longitude) {
+        stop_names_.push_back("Stop "s + to_string(stop_names_.size()));
+        coordinates_.push_back({latitude, longitude});
+    }
+
+    size_t GetRouteLength() {
+        return uniform_int_distribution<size_t>(options_.min_route_stops, options_.max_route_stops)(random_);
+    }
+
+    // Дорожное расстояние на 0-40% длиннее расстояния по прямой
+    void AddBus(vector<size_t> route, bool is_roundtrip) {
+        if (route.size() < 2) {
+            return;
+        }
+        if (is_roundtrip && route.front() != route.back()) {
+            route.push_back(route.front());
+        }
+        uniform_real_distribution<double> detour(1.0, 1.4);
+        for (size_t i = 1; i < route.size(); ++i) {
+            const size_t from = route[i - 1];
+            const size_t to = route[i];
+            auto& distances = distances_[stop_names_[from]];
+            if (distances.count(stop_names_[to]) == 0) {
+                const double geo_distance = geo::ComputeDistance(coordinates_[from], coordinates_[to]);
+                distances[stop_names_[to]] = round(geo_distance * detour(random_)) + 1;
+            }
+        }
+        bus_routes_.push_back({move(route), is_roundtrip});
+    }
+
+    void GenerateGrid() {
+        const size_t side = static_cast<size_t>(ceil(sqrt(static_cast<double>(options_.stops))));
+        for (size_t i = 0; i < options_.stops; ++i) {
+            AddStop(55.0 + static_cast<double>(i / side) * 0.003, 37.0 + static_cast<double>(i % side) * 0.005);
+        }
+
+        uniform_int_distribution<size_t> stop_distribution(0, options_.stops - 1);
+        bernoulli_distribution roundtrip_distribution(0.3);
+        for (size_t bus = 0; bus < options_.buses; ++bus) {
+            const size_t length = GetRouteLength();
+            vector<size_t> route{stop_distribution(random_)};
+            vector<bool> on_route(options_.stops, false);
+            on_route[route.back()] = true;
+            while (route.size() < length) {
+                const size_t x = route.back() % side;
+                const size_t y = route.back() / side;
+                vector<size_t> neighbours;
+                if (x > 0) neighbours.push_back(route.back() - 1);
+                if (x + 1 < side && route.back() + 1 < options_.stops) neighbours.push_back(route.back() + 1);
+                if (y > 0) neighbours.push_back(route.back() - side);
+                if (route.back() + side < options_.stops) neighbours.push_back(route.back() + side);
+                neighbours.erase(remove_if(neighbours.begin(), neighbours.end(),
+                                           [&on_route](size_t stop) { return on_route[stop]; }),
+                                 neighbours.end());
+                if (neighbours.empty()) {
+                    break;
+                }
+                route.push_back(neighbours[uniform_int_distribution<size_t>(0, neighbours.size() - 1)(random_)]);
+                on_route[route.back()] = true;
+            }
+            AddBus(move(route), roundtrip_distribution(random_));
+        }
+    }
+
+    void GenerateRadial() {
+        const size_t spokes = max<size_t>(3, static_cast<size_t>(round(sqrt(static_cast<double>(options_.stops - 1)))));
+        const size_t rings = max<size_t>(1, (options_.stops - 1) / spokes);
+        const geo::Coordinates center{55.75, 37.62};
+        const double pi = acos(-1.0);
+
+        AddStop(center.lat, center.lng);
+        for (size_t ring = 1; ring <= rings; ++ring) {
+            for (size_t spoke = 0; spoke < spokes; ++spoke) {
+                const double angle = 2 * pi * static_cast<double>(spoke) / static_cast<double>(spokes);
+                const double radius = static_cast<double>(ring) * 0.004;
+                AddStop(center.lat + radius * sin(angle), center.lng + radius * 1.7 * cos(angle));
+            }
+        }
+        const auto stop_at = [spokes](size_t ring, size_t spoke) {
+            return ring == 0 ? size_t{0} : 1 + (ring - 1) * spokes + spoke % spokes;
+        };
+
+        uniform_int_distribution<size_t> spoke_distribution(0, spokes - 1);
+        uniform_int_distribution<size_t> ring_distribution(1, rings);
+        bernoulli_distribution coin(0.5);
+        for (size_t bus = 0; bus < options_.buses; ++bus) {
+            const size_t length = GetRouteLength();
+            vector<size_t> route;
+            if (bus % 2 == 0) {
+                // Радиальный маршрут: от внешнего кольца к центру, иногда дальше по противоположному лучу
+                const size_t spoke = spoke_distribution(random_);
+                const size_t first_ring = ring_distribution(random_);
+                for (size_t ring = first_ring; route.size() < length; --ring) {
+                    route.push_back(stop_at(ring, spoke));
+                    if (ring == 0) {
+                        break;
+                    }
+                }
+                if (coin(random_)) {
+                    for (size_t ring = 1; ring <= rings && route.size() < length; ++ring) {
+                        route.push_back(stop_at(ring, spoke + spokes / 2));
+                    }
+                }
+                AddBus(move(route), false);
+            } else {
+                // Кольцевой маршрут: дуга кольца, полный круг делается кольцевым
+                const size_t ring = ring_distribution(random_);
+                const size_t first_spoke = spoke_distribution(random_);
+                for (size_t i = 0; i < min(length, spokes); ++i) {
+                    route.push_back(stop_at(ring, first_spoke + i));
+                }
+                const bool is_roundtrip = route.size() == spokes || coin(random_);
+                AddBus(move(route), is_roundtrip);
+            }
+        }
+    }
+
+    TransportCatalogue& db_;
+    const BenchOptions& options_;
+    mt19937 random_;
+
+    vector<string> stop_names_;
+    vector<geo::Coordinates> coordinates_;
+    map<string, map<string, double>> distances_;
+    vector<pair<vector<size_t>, bool>> bus_routes_;
+};
+
+// Текущий размер резидентной памяти процесса; 0, если /proc недоступен
+double GetResidentMegabytes() {
+#ifdef __unix__
+    ifstream statm("/proc/self/statm"s);
+    size_t total_pages = 0;
+    size_t resident_pages = 0;
+    if (!(statm >> total_pages >> resident_pages)) {
+        return 0;
+    }
+    return static_cast<double>(resident_pages) * static_cast<double>(sysconf(_SC_PAGESIZE)) / 1024 / 1024;
+#else
+    return 0;
+#endif
+}
+
+// Возвращает системе освобождённую память предыдущего маршрутизатора, чтобы она не исказила
+// замер следующего: иначе он занимает уже резидентные страницы и его рост памяти занижается
+void ReleaseFreeMemory() {
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+}
+
+template <typename Func>
+double MeasureMilliseconds(Func func) {
+    const auto start = chrono::steady_clock::now();
+    func();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+double GetPercentile(const vector<double>& sorted_values, double percentile) {
+    if (sorted_values.empty()) {
+        return 0;
+    }
+    const size_t index = static_cast<size_t>(percentile / 100 * static_cast<double>(sorted_values.size()));
+    return sorted_values[min(index, sorted_values.size() - 1)];
+}
+
+router::RoutingSettings MakeRoutingSettings(const BenchOptions& options, const string& router_name) {
+    router::RoutingSettings settings;
+    settings.bus_velocity = options.bus_velocity;
+    settings.bus_wait_time = options.bus_wait_time;
+    settings.router_type = router::ParseRouterType(router_name);
+    settings.vertex_order = router::ParseVertexOrder(options.vertex_order);
+    return settings;
+}
+
+// Ответы на запросы бенчмарка для сверки маршрутизаторов между собой
+struct QueryAnswer {
+    bool found = false;
+    RouteResult route;
+};
+
+// Расхождения с эталоном: запросы с другим общим временем (или найденностью), запросы с тем же
+// временем, но другим списком элементов (другой из равноценных маршрутов), и ответы, элементы
+// которых не складываются в настоящую поездку от начальной остановки до конечной
+struct AnswersDiff {
+    size_t time_mismatches = 0;
+    size_t item_mismatches = 0;
+    size_t invalid_routes = 0;
+};
+
+bool IsSameTime(double lhs, double rhs) {
+    return abs(lhs - rhs) <= 1e-9 * max(1.0, abs(lhs));
+}
+
+bool IsSameItems(const vector<RouteItem>& lhs, const vector<RouteItem>& rhs) {
+    return equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const RouteItem& lhs, const RouteItem& rhs) {
+        return lhs.kind == rhs.kind && lhs.id == rhs.id && lhs.span_count == rhs.span_count &&
+               IsSameTime(lhs.time, rhs.time);
+    });
+}
+
+// Есть ли у автобуса (в любом направлении его движения) перегон из span_count остановок от from до to
+bool HasSpan(const Bus& bus, uint32_t from, uint32_t to, uint32_t span_count) {
+    const auto has_span = [&](auto begin, auto end) {
+        for (auto it = begin; end - it > span_count; ++it) {
+            if (GetStopIndex(**it) == from && GetStopIndex(**(it + span_count)) == to) {
+                return true;
+            }
+        }
+        return false;
+    };
+    return has_span(bus.route.begin(), bus.route.end()) ||
+           (!bus.is_roundtrip && has_span(bus.route.rbegin(), bus.route.rend()));
+}
+
+// Маршрут - чередование ожиданий и поездок, начинающееся на from и заканчивающееся на to,
+// с суммой времён, равной общему времени
+bool IsValidRoute(const TransportCatalogue& db, const BenchOptions& options, const Stop& from, const Stop& to,
+                  const RouteResult& route) {
+    uint32_t stop = GetStopIndex(from);
+    double total_time = 0;
+    for (size_t i = 0; i < route.items.size(); ++i) {
+        const RouteItem& item = route.items[i];
+        total_time += item.time;
+        if (i % 2 == 0) {
+            if (item.kind != RouteItemKind::WAIT || item.id != stop || !IsSameTime(item.time, options.bus_wait_time)) {
+                return false;
+            }
+            continue;
+        }
+        if (item.kind != RouteItemKind::BUS || item.id >= db.GetAllBuses().size() || item.span_count == 0) {
+            return false;
+        }
+        const uint32_t next_stop = i + 1 < route.items.size() ? route.items[i + 1].id : GetStopIndex(to);
+        if (!HasSpan(db.GetAllBuses()[item.id], stop, next_stop, item.span_count)) {
+            return false;
+        }
+        stop = next_stop;
+    }
+    return route.items.size() % 2 == 0 && stop == GetStopIndex(to) && IsSameTime(total_time, route.total_time);
+}
+
+AnswersDiff CompareAnswers(const TransportCatalogue& db, const BenchOptions& options,
+                           const vector<pair<const Stop*, const Stop*>>& queries,
+                           const vector<QueryAnswer>& reference, const vector<QueryAnswer>& answers) {
+    AnswersDiff diff;
+    for (size_t i = 0; i < reference.size(); ++i) {
+        const QueryAnswer& expected = reference[i];
+        const QueryAnswer& actual = answers[i];
+        if (actual.found && !IsValidRoute(db, options, *queries[i].first, *queries[i].second, actual.route)) {
+            ++diff.invalid_routes;
+        }
+        if (expected.found != actual.found ||
+            (expected.found && !IsSameTime(expected.route.total_time, actual.route.total_time))) {
+            ++diff.time_mismatches;
+        } else if (expected.found && !IsSameItems(expected.route.items, actual.route.items)) {
+            ++diff.item_mismatches;
+        }
+    }
+    return diff;
+}
+
+vector<QueryAnswer> CollectAnswers(const TransportCatalogue& db, const BenchOptions& options,
+                                   const vector<pair<const Stop*, const Stop*>>& queries, const string& router_name) {
+    router::RoutingSettings settings = MakeRoutingSettings(options, router_name);
+    router::TransportRouter transport_router(settings);
+    transport_router.SetVertexAmount(db.GetAllStops().size() * 2);
+    transport_router.FillDataToGraph(db.GetAllBuses(), db.GetDistancesMap());
+
+    vector<QueryAnswer> answers(queries.size());
+    for (size_t i = 0; i < queries.size(); ++i) {
+        answers[i].found = transport_router.BuildRoute(queries[i].first, queries[i].second, answers[i].route);
+    }
+    return answers;
+}
+
+// Общее время маршрута по каждому запросу, nullopt - маршрут не найден
+using RouteTimes = vector<optional<double>>;
+
+size_t CountAgreements(const RouteTimes& expected, const RouteTimes& actual) {
+    size_t agreements = 0;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (expected[i].has_value() == actual[i].has_value() && (!expected[i] || IsSameTime(*expected[i], *actual[i]))) {
+            ++agreements;
+        }
+    }
+    return agreements;
+}
+
+// Граф и маршрутизатор строятся по одному разу и измеряются порознь; память замеряется после
+// графа, после маршрутизатора и после запросов (кэши и рабочие массивы поиска растут по ходу).
+// Ответы сравниваются по общему времени с baseline_times (первым маршрутизатором в списке);
+// возвращает расхождения с эталоном, если он передан
+optional<AnswersDiff> RunBench(const TransportCatalogue& db, const BenchOptions& options,
+                               const vector<pair<const Stop*, const Stop*>>& queries, const string& router_name,
+                               const vector<QueryAnswer>* reference, RouteTimes& route_times,
+                               const RouteTimes* baseline_times) {
+    ReleaseFreeMemory();
+    const double resident_before = GetResidentMegabytes();
+    router::RoutingSettings settings = MakeRoutingSettings(options, router_name);
+    router::TransportRouter transport_router(settings);
+
+    const double graph_ms = MeasureMilliseconds([&]() {
+        transport_router.SetVertexAmount(db.GetAllStops().size() * 2);
+        transport_router.BuildGraph(db.GetAllBuses(), db.GetDistancesMap());
+    });
+    const double resident_graph = GetResidentMegabytes();
+    const double router_ms = MeasureMilliseconds([&]() {
+        transport_router.BuildRouter();
+    });
+    const double resident_router = GetResidentMegabytes();
+
+    vector<double> latencies(queries.size());
+    route_times.assign(queries.size(), nullopt);
+    graph::ParallelFor(queries.size(), options.threads, [&](size_t index) {
+        thread_local RouteResult route;
+        const auto start = chrono::steady_clock::now();
+        const bool found = transport_router.BuildRoute(queries[index].first, queries[index].second, route);
+        latencies[index] = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+        if (found) {
+            route_times[index] = route.total_time;
+        }
+    });
+    const double resident_queries = GetResidentMegabytes();
+    const size_t found = static_cast<size_t>(count_if(route_times.begin(), route_times.end(), [](const auto& time) {
+        return time.has_value();
+    }));
+    sort(latencies.begin(), latencies.end());
+
+    // Ответы для сверки собираются отдельным проходом, чтобы копирование не попадало в задержки
+    optional<AnswersDiff> diff;
+    if (reference) {
+        vector<QueryAnswer> answers(queries.size());
+        for (size_t i = 0; i < queries.size(); ++i) {
+            answers[i].found = transport_router.BuildRoute(queries[i].first, queries[i].second, answers[i].route);
+        }
+        diff = CompareAnswers(db, options, queries, *reference, answers);
+    }
+
+    const auto& graph = transport_router.GetGraph();
+    cout << setw(24) << left << router_name << right
+         << setw(9) << graph.GetVertexCount()
+         << setw(11) << graph.GetEdgeCount()
+         << fixed << setprecision(1)
+         << setw(11) << graph_ms
+         << setw(11) << router_ms
+         << setw(10) << resident_graph - resident_before
+         << setw(10) << resident_router - resident_graph
+         << setw(10) << resident_queries - resident_router
+         << setw(8) << found
+         << setw(10) << GetPercentile(latencies, 50)
+         << setw(10) << GetPercentile(latencies, 90)
+         << setw(10) << GetPercentile(latencies, 99)
+         << setw(11) << (latencies.empty() ? 0 : latencies.back())
+         << setw(8) << CountAgreements(baseline_times ? *baseline_times : route_times, route_times);
+    if (diff) {
+        cout << setw(11) << diff->time_mismatches << setw(11) << diff->item_mismatches
+             << setw(9) << diff->invalid_routes;
+    }
+    cout << endl;
+    return diff;
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    try {
+        if (!ParseOptions(argc, argv, options)) {
+            PrintUsage();
+            return 1;
+        }
+    } catch (const exception&) {
+        PrintUsage();
+        return 1;
+    }
+
+    TransportCatalogue db;
+    NetworkGenerator(db, options).Generate();
+
+    const auto& stops = db.GetAllStops();
+    mt19937 random(options.seed + 1);
+    uniform_int_distribution<size_t> stop_distribution(0, stops.size() - 1);
+    vector<pair<const Stop*, const Stop*>> queries;
+    for (size_t i = 0; i < options.queries; ++i) {
+        queries.push_back({&stops[stop_distribution(random)], &stops[stop_distribution(random)]});
+    }
+
+    cout << "layout "sv << options.layout << ": "sv << stops.size() << " stops, "sv
+         << db.GetAllBuses().size() << " buses, "sv << options.queries << " queries, seed "sv << options.seed
+         << ", "sv << options.threads << " threads, vertex order "sv << options.vertex_order << (options.shuffle_stops ? ", shuffled stops"sv : ""sv) << '\n';
+    cout << setw(24) << left << "router"sv << right
+         << setw(9) << "vertices"sv
+         << setw(11) << "edges"sv
+         << setw(11) << "graph_ms"sv
+         << setw(11) << "router_ms"sv
+         << setw(10) << "graph_mb"sv
+         << setw(10) << "router_mb"sv
+         << setw(10) << "query_mb"sv
+         << setw(8) << "found"sv
+         << setw(10) << "p50_us"sv
+         << setw(10) << "p90_us"sv
+         << setw(10) << "p99_us"sv
+         << setw(11) << "max_us"sv
+         << setw(8) << "agree"sv;
+    if (options.check) {
+        cout << setw(11) << "time_diff"sv << setw(11) << "item_diff"sv << setw(9) << "invalid"sv;
+    }
+    cout << endl;
+
+    // Эталон - полная таблица all_pairs. Ошибкой считаются другое общее время и негодный маршрут;
+    // другой список элементов при том же времени - лишь другой выбор среди равноценных маршрутов
+    vector<QueryAnswer> reference;
+    if (options.check) {
+        reference = CollectAnswers(db, options, queries, "all_pairs"s);
+    }
+
+    // agree - число запросов, на которые маршрутизатор дал то же общее время, что и первый в списке
+    bool has_mismatches = false;
+    bool answers_agree = true;
+    optional<RouteTimes> baseline_times;
+    for (const string& router_name : options.routers) {
+        try {
+            RouteTimes route_times;
+            const auto diff = RunBench(db, options, queries, router_name, options.check ? &reference : nullptr,
+                                       route_times, baseline_times ? &*baseline_times : nullptr);
+            if (!baseline_times) {
+                baseline_times = move(route_times);
+            } else if (CountAgreements(*baseline_times, route_times) != queries.size()) {
+                answers_agree = false;
+            }
+            if (diff && (diff->time_mismatches > 0 || diff->invalid_routes > 0)) {
+                has_mismatches = true;
+            }
+        } catch (const exception& e) {
+            cout << setw(24) << left << router_name << right << " failed: "sv << e.what() << endl;
+            has_mismatches = has_mismatches || options.check;
+        }
+    }
+    cout << (answers_agree ? "all routers agree on route times"sv : "routers DISAGREE on route times"sv) << endl;
+    return has_mismatches ? 2 : 0;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "graph.h"
+#include "search_workspace.h"
+
+#include <stdexcept>
+#include <vector>
+
+namespace graph {
+
+// Дейкстра из одной вершины, ограниченная весом пути: оседают только вершины с весом
+// не больше max_weight. Поиск идёт по рабочему месту потока (GetThreadWorkspace), которое
+// сбрасывается сменой поколения, поэтому серия поисков с небольшим радиусом не платит за размер
+// графа, а Run можно вызывать из нескольких потоков одновременно
+template <typename Weight>
+class BoundedSearch {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    struct ReachedVertex {
+        VertexId vertex;
+        Weight weight;
+    };
+
+    explicit BoundedSearch(const Graph& graph);
+
+    // Заполняет reached достигнутыми вершинами в порядке неубывания веса, первой идёт from
+    void Run(VertexId from, Weight max_weight, std::vector<ReachedVertex>& reached) const;
+
+private:
+    static constexpr Weight ZERO_WEIGHT{};
+    CompressedGraph<Weight> compressed_graph_;
+};
+
+template <typename Weight>
+BoundedSearch<Weight>::BoundedSearch(const Graph& graph)
+    : compressed_graph_(graph)
+{
+    const size_t edge_count = graph.GetEdgeCount();
+    for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+}
+
+template <typename Weight>
+void BoundedSearch<Weight>::Run(VertexId from, Weight max_weight, std::vector<ReachedVertex>& reached) const {
+    const size_t vertex_count = compressed_graph_.GetVertexCount();
+    if (from >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    reached.clear();
+    if (max_weight < ZERO_WEIGHT) {
+        return;
+    }
+
+    auto& workspace = GetThreadWorkspace<Weight>(0);
+    workspace.Reset(vertex_count);
+    auto& frontier = workspace.frontier;
+    workspace.Reach(from, ZERO_WEIGHT, SearchWorkspace<Weight>::NO_EDGE);
+    frontier.Push(ZERO_WEIGHT, from);
+
+    while (!frontier.IsEmpty()) {
+        const auto [weight, vertex] = frontier.Pop();
+        if (workspace.IsSettled(vertex)) {
+            continue;
+        }
+        workspace.Settle(vertex);
+        reached.push_back({vertex, weight});
+
+        const size_t edges_end = compressed_graph_.GetFirstEdge(vertex + 1);
+        for (size_t position = compressed_graph_.GetFirstEdge(vertex); position < edges_end; ++position) {
+            const VertexId target = compressed_graph_.GetEdgeTarget(position);
+            const Weight candidate_weight = weight + compressed_graph_.GetEdgeWeight(position);
+            // Вершины за пределами бюджета даже не попадают в очередь
+            if (max_weight < candidate_weight) {
+                continue;
+            }
+            if (!workspace.IsReached(target) || candidate_weight < workspace.GetWeight(target)) {
+                workspace.Reach(target, candidate_weight, compressed_graph_.GetEdgeId(position));
+                frontier.Push(candidate_weight, target);
+            }
+        }
+    }
+}
+
+}  // namespace graph
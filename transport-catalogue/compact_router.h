@@ -0,0 +1,195 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "min_plus_kernel.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Таблица маршрутов всех пар вершин в одном непрерывном блоке памяти: веса хранятся
+// в типе StoredWeight (по умолчанию float), предыдущие рёбра - 32-битными индексами.
+// Недостижимые пары кодируются бесконечным весом, отсутствие предыдущего ребра - NO_EDGE.
+// Вес найденного маршрута пересчитывается по исходным рёбрам в Weight, поэтому
+// пониженная точность таблицы влияет только на выбор среди почти равных маршрутов.
+// Для таблицы float внутренний цикл расчёта выполняется векторным ядром min_plus.
+template <typename Weight, typename StoredWeight = float>
+class CompactRouter : public RouterBase<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+    using CompactEdgeId = uint32_t;
+
+    static constexpr CompactEdgeId NO_EDGE = std::numeric_limits<CompactEdgeId>::max();
+    static constexpr StoredWeight NO_ROUTE = std::numeric_limits<StoredWeight>::infinity();
+
+    explicit CompactRouter(const Graph& graph);
+    CompactRouter(const Graph& graph, std::vector<StoredWeight> weights, std::vector<CompactEdgeId> prev_edges);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    std::optional<Weight> BuildRouteInto(VertexId from, VertexId to, std::vector<EdgeId>& edges) const override;
+
+    const std::vector<StoredWeight>& GetWeights() const;
+    const std::vector<CompactEdgeId>& GetPrevEdges() const;
+
+private:
+    void InitializeTable();
+    void RelaxTableThroughVertex(VertexId vertex_through);
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+    size_t vertex_count_;
+    // Ячейка (from, to) лежит по индексу from * vertex_count_ + to
+    std::vector<StoredWeight> weights_;
+    std::vector<CompactEdgeId> prev_edges_;
+};
+
+template <typename Weight, typename StoredWeight>
+CompactRouter<Weight, StoredWeight>::CompactRouter(const Graph& graph)
+    : graph_(graph)
+    , vertex_count_(graph.GetVertexCount())
+    , weights_(vertex_count_ * vertex_count_, NO_ROUTE)
+    , prev_edges_(vertex_count_ * vertex_count_, NO_EDGE)
+{
+    if (graph.GetEdgeCount() >= NO_EDGE) {
+        throw std::length_error("Too many edges for compact route table");
+    }
+
+    InitializeTable();
+    for (VertexId vertex_through = 0; vertex_through < vertex_count_; ++vertex_through) {
+        RelaxTableThroughVertex(vertex_through);
+    }
+}
+
+template <typename Weight, typename StoredWeight>
+CompactRouter<Weight, StoredWeight>::CompactRouter(const Graph& graph, std::vector<StoredWeight> weights,
+                                                   std::vector<CompactEdgeId> prev_edges)
+    : graph_(graph)
+    , vertex_count_(graph.GetVertexCount())
+    , weights_(std::move(weights))
+    , prev_edges_(std::move(prev_edges))
+{
+    if (weights_.size() != vertex_count_ * vertex_count_ || prev_edges_.size() != weights_.size()) {
+        throw std::invalid_argument("Routes data doesn't match the graph");
+    }
+    for (const CompactEdgeId edge_id : prev_edges_) {
+        if (edge_id != NO_EDGE && edge_id >= graph.GetEdgeCount()) {
+            throw std::invalid_argument("Routes data doesn't match the graph");
+        }
+    }
+}
+
+template <typename Weight, typename StoredWeight>
+const std::vector<StoredWeight>& CompactRouter<Weight, StoredWeight>::GetWeights() const {
+    return weights_;
+}
+
+template <typename Weight, typename StoredWeight>
+const std::vector<typename CompactRouter<Weight, StoredWeight>::CompactEdgeId>&
+CompactRouter<Weight, StoredWeight>::GetPrevEdges() const {
+    return prev_edges_;
+}
+
+template <typename Weight, typename StoredWeight>
+void CompactRouter<Weight, StoredWeight>::InitializeTable() {
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+        weights_[vertex * vertex_count_ + vertex] = StoredWeight{};
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            const size_t cell = vertex * vertex_count_ + edge.to;
+            const auto edge_weight = static_cast<StoredWeight>(edge.weight);
+            if (edge_weight < weights_[cell]) {
+                weights_[cell] = edge_weight;
+                prev_edges_[cell] = static_cast<CompactEdgeId>(edge_id);
+            }
+        }
+    }
+}
+
+template <typename Weight, typename StoredWeight>
+void CompactRouter<Weight, StoredWeight>::RelaxTableThroughVertex(VertexId vertex_through) {
+    const StoredWeight* weights_through = weights_.data() + vertex_through * vertex_count_;
+    const CompactEdgeId* prev_edges_through = prev_edges_.data() + vertex_through * vertex_count_;
+    [[maybe_unused]] const min_plus::RelaxRowFunction relax_row = min_plus::GetRelaxRow();
+
+    for (VertexId vertex_from = 0; vertex_from < vertex_count_; ++vertex_from) {
+        StoredWeight* weights_from = weights_.data() + vertex_from * vertex_count_;
+        CompactEdgeId* prev_edges_from = prev_edges_.data() + vertex_from * vertex_count_;
+        const StoredWeight weight_from = weights_from[vertex_through];
+        if (weight_from == NO_ROUTE) {
+            continue;
+        }
+        const CompactEdgeId prev_edge_from = prev_edges_from[vertex_through];
+
+        if constexpr (std::is_same_v<StoredWeight, float>) {
+            relax_row(weight_from, prev_edge_from, weights_through, prev_edges_through,
+                      weights_from, prev_edges_from, vertex_count_);
+            continue;
+        }
+
+        // Недостижимые ячейки строки vertex_through дают бесконечного кандидата и не проходят сравнение
+        for (VertexId vertex_to = 0; vertex_to < vertex_count_; ++vertex_to) {
+            const StoredWeight candidate_weight = weight_from + weights_through[vertex_to];
+            if (candidate_weight < weights_from[vertex_to]) {
+                weights_from[vertex_to] = candidate_weight;
+                prev_edges_from[vertex_to] =
+                    prev_edges_through[vertex_to] != NO_EDGE ? prev_edges_through[vertex_to] : prev_edge_from;
+            }
+        }
+    }
+}
+
+template <typename Weight, typename StoredWeight>
+std::optional<Weight> CompactRouter<Weight, StoredWeight>::BuildRouteInto(VertexId from, VertexId to,
+                                                                          std::vector<EdgeId>& edges) const {
+    if (from >= vertex_count_ || to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    const size_t row = from * vertex_count_;
+    MarkSearchFinished(GetThreadSearchStats());
+    if (weights_[row + to] == NO_ROUTE) {
+        return std::nullopt;
+    }
+
+    edges.clear();
+    for (CompactEdgeId edge_id = prev_edges_[row + to];
+         edge_id != NO_EDGE;
+         edge_id = prev_edges_[row + graph_.GetEdge(edge_id).from])
+    {
+        edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    Weight weight = ZERO_WEIGHT;
+    for (const EdgeId edge_id : edges) {
+        weight = weight + graph_.GetEdge(edge_id).weight;
+    }
+
+    return weight;
+}
+
+template <typename Weight, typename StoredWeight>
+std::optional<typename CompactRouter<Weight, StoredWeight>::RouteInfo>
+CompactRouter<Weight, StoredWeight>::BuildRoute(VertexId from, VertexId to) const {
+    std::vector<EdgeId> edges;
+    const auto weight = BuildRouteInto(from, to, edges);
+    if (!weight) {
+        return std::nullopt;
+    }
+    return RouteInfo{*weight, std::move(edges)};
+}
+
+}  // namespace graph
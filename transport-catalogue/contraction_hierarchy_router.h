@@ -0,0 +1,497 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "search_workspace.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Иерархия сжатий (Contraction Hierarchies): вершины упорядочиваются по важности и
+// последовательно стягиваются с добавлением рёбер-сокращений. Запрос - двунаправленный
+// поиск только по рёбрам к более важным вершинам, сокращения затем раскрываются
+// в исходные рёбра графа.
+template <typename Weight>
+class ContractionHierarchyRouter : public RouterBase<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+    static constexpr size_t NO_EDGE = std::numeric_limits<size_t>::max();
+
+    struct HierarchyEdge {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+        EdgeId original_edge = NO_EDGE;
+        // Для сокращений - индексы двух рёбер иерархии, из которых оно составлено
+        size_t lower_edge = NO_EDGE;
+        size_t upper_edge = NO_EDGE;
+    };
+
+    explicit ContractionHierarchyRouter(const Graph& graph);
+    ContractionHierarchyRouter(const Graph& graph, std::vector<size_t> ranks,
+                               std::vector<HierarchyEdge> edges);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    const std::vector<size_t>& GetRanks() const;
+    const std::vector<HierarchyEdge>& GetHierarchyEdges() const;
+
+private:
+    // Поиск свидетелей ограничен, чтобы стягивание оставалось локальным: если свидетель
+    // не найден в пределах лимита, добавляется (возможно лишнее) сокращение
+    static constexpr size_t WITNESS_SETTLE_LIMIT = 500;
+    static constexpr size_t SIMULATION_SETTLE_LIMIT = 50;
+
+    struct QueueItem {
+        Weight weight;
+        VertexId vertex;
+
+        bool operator>(const QueueItem& other) const {
+            return other.weight < weight;
+        }
+    };
+    using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+    struct Neighbour {
+        VertexId vertex;
+        Weight weight;
+        size_t edge;
+    };
+
+    struct ContractionState {
+        std::vector<std::vector<size_t>> out_edges;
+        std::vector<std::vector<size_t>> in_edges;
+        std::vector<bool> contracted;
+        std::vector<int> deleted_neighbours;
+
+        std::vector<std::optional<Weight>> witness_weights;
+        std::vector<VertexId> witness_touched;
+        std::vector<bool> witness_targets;
+    };
+
+    void AddOriginalEdges(const Graph& graph);
+    void Contract();
+    std::vector<Neighbour> CollectNeighbours(const ContractionState& state, VertexId vertex,
+                                             bool outgoing) const;
+    void RunWitnessSearch(ContractionState& state, VertexId source, VertexId excluded,
+                          Weight max_weight, size_t target_count, size_t settle_limit) const;
+    int ContractVertex(ContractionState& state, VertexId vertex, bool simulate);
+    void BuildSearchGraphs();
+    void UnpackEdge(size_t edge, std::vector<EdgeId>& edges) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+    std::vector<size_t> ranks_;
+    std::vector<HierarchyEdge> edges_;
+    // Рёбра к более важным вершинам: прямые для поиска от начала, развёрнутые - от конца.
+    // Идентификатор ребра в этих графах - индекс ребра иерархии
+    CompressedGraph<Weight> upward_graph_;
+    CompressedGraph<Weight> downward_graph_;
+};
+
+template <typename Weight>
+ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph& graph)
+    : graph_(graph)
+    , ranks_(graph.GetVertexCount())
+{
+    AddOriginalEdges(graph);
+    Contract();
+    BuildSearchGraphs();
+}
+
+template <typename Weight>
+ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph& graph,
+                                                               std::vector<size_t> ranks,
+                                                               std::vector<HierarchyEdge> edges)
+    : graph_(graph)
+    , ranks_(std::move(ranks))
+    , edges_(std::move(edges))
+{
+    const size_t vertex_count = graph.GetVertexCount();
+    if (ranks_.size() != vertex_count) {
+        throw std::invalid_argument("Contraction hierarchy doesn't match the graph");
+    }
+    // Сокращение составлено из рёбер, добавленных раньше него, поэтому распаковка конечна
+    for (size_t edge = 0; edge < edges_.size(); ++edge) {
+        const auto& hierarchy_edge = edges_[edge];
+        const bool is_valid_edge = hierarchy_edge.original_edge != NO_EDGE
+            ? hierarchy_edge.original_edge < graph.GetEdgeCount()
+            : hierarchy_edge.lower_edge < edge && hierarchy_edge.upper_edge < edge;
+        if (hierarchy_edge.from >= vertex_count || hierarchy_edge.to >= vertex_count || !is_valid_edge) {
+            throw std::invalid_argument("Contraction hierarchy doesn't match the graph");
+        }
+    }
+    BuildSearchGraphs();
+}
+
+template <typename Weight>
+const std::vector<size_t>& ContractionHierarchyRouter<Weight>::GetRanks() const {
+    return ranks_;
+}
+
+template <typename Weight>
+const std::vector<typename ContractionHierarchyRouter<Weight>::HierarchyEdge>&
+ContractionHierarchyRouter<Weight>::GetHierarchyEdges() const {
+    return edges_;
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::AddOriginalEdges(const Graph& graph) {
+    // Из параллельных рёбер в кратчайший путь может попасть только самое лёгкое
+    std::vector<EdgeId> edge_ids;
+    edge_ids.reserve(graph.GetEdgeCount());
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        if (edge.from != edge.to) {
+            edge_ids.push_back(edge_id);
+        }
+    }
+    std::sort(edge_ids.begin(), edge_ids.end(), [&graph](EdgeId lhs, EdgeId rhs) {
+        const auto& lhs_edge = graph.GetEdge(lhs);
+        const auto& rhs_edge = graph.GetEdge(rhs);
+        return std::tie(lhs_edge.from, lhs_edge.to, lhs_edge.weight, lhs)
+             < std::tie(rhs_edge.from, rhs_edge.to, rhs_edge.weight, rhs);
+    });
+
+    for (const EdgeId edge_id : edge_ids) {
+        const auto& edge = graph.GetEdge(edge_id);
+        if (!edges_.empty() && edges_.back().from == edge.from && edges_.back().to == edge.to) {
+            continue;
+        }
+        edges_.push_back({edge.from, edge.to, edge.weight, edge_id});
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::Contract() {
+    const size_t vertex_count = ranks_.size();
+
+    ContractionState state;
+    state.out_edges.resize(vertex_count);
+    state.in_edges.resize(vertex_count);
+    state.contracted.assign(vertex_count, false);
+    state.deleted_neighbours.assign(vertex_count, 0);
+    state.witness_weights.resize(vertex_count);
+    state.witness_targets.assign(vertex_count, false);
+    for (size_t edge = 0; edge < edges_.size(); ++edge) {
+        state.out_edges[edges_[edge].from].push_back(edge);
+        state.in_edges[edges_[edge].to].push_back(edge);
+    }
+
+    using PriorityItem = std::pair<int, VertexId>;
+    std::priority_queue<PriorityItem, std::vector<PriorityItem>, std::greater<PriorityItem>> order;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        order.push({ContractVertex(state, vertex, true), vertex});
+    }
+
+    size_t next_rank = 0;
+    while (!order.empty()) {
+        const VertexId vertex = order.top().second;
+        order.pop();
+        if (state.contracted[vertex]) {
+            continue;
+        }
+
+        // Ленивое обновление: приоритет мог устареть после стягивания соседей
+        const int priority = ContractVertex(state, vertex, true);
+        if (!order.empty() && priority > order.top().first) {
+            order.push({priority, vertex});
+            continue;
+        }
+
+        ContractVertex(state, vertex, false);
+        state.contracted[vertex] = true;
+        ranks_[vertex] = next_rank++;
+    }
+}
+
+template <typename Weight>
+std::vector<typename ContractionHierarchyRouter<Weight>::Neighbour>
+ContractionHierarchyRouter<Weight>::CollectNeighbours(const ContractionState& state, VertexId vertex,
+                                                      bool outgoing) const {
+    std::vector<Neighbour> neighbours;
+    for (const size_t edge : outgoing ? state.out_edges[vertex] : state.in_edges[vertex]) {
+        const VertexId neighbour = outgoing ? edges_[edge].to : edges_[edge].from;
+        if (!state.contracted[neighbour]) {
+            neighbours.push_back({neighbour, edges_[edge].weight, edge});
+        }
+    }
+
+    std::sort(neighbours.begin(), neighbours.end(), [](const Neighbour& lhs, const Neighbour& rhs) {
+        return std::tie(lhs.vertex, lhs.weight, lhs.edge) < std::tie(rhs.vertex, rhs.weight, rhs.edge);
+    });
+    neighbours.erase(std::unique(neighbours.begin(), neighbours.end(),
+                                 [](const Neighbour& lhs, const Neighbour& rhs) {
+                                     return lhs.vertex == rhs.vertex;
+                                 }),
+                     neighbours.end());
+    return neighbours;
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::RunWitnessSearch(ContractionState& state, VertexId source,
+                                                          VertexId excluded, Weight max_weight,
+                                                          size_t target_count, size_t settle_limit) const {
+    for (const VertexId vertex : state.witness_touched) {
+        state.witness_weights[vertex].reset();
+    }
+    state.witness_touched.clear();
+
+    Queue queue;
+    state.witness_weights[source] = ZERO_WEIGHT;
+    state.witness_touched.push_back(source);
+    queue.push({ZERO_WEIGHT, source});
+
+    size_t settled_count = 0;
+    while (!queue.empty() && settled_count < settle_limit && target_count > 0) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (*state.witness_weights[vertex] < weight) {
+            continue;
+        }
+        ++settled_count;
+        if (state.witness_targets[vertex]) {
+            --target_count;
+        }
+
+        for (const size_t edge : state.out_edges[vertex]) {
+            const VertexId target = edges_[edge].to;
+            if (target == excluded || state.contracted[target]) {
+                continue;
+            }
+            const Weight candidate_weight = weight + edges_[edge].weight;
+            if (max_weight < candidate_weight) {
+                continue;
+            }
+            auto& target_weight = state.witness_weights[target];
+            if (!target_weight || candidate_weight < *target_weight) {
+                if (!target_weight) {
+                    state.witness_touched.push_back(target);
+                }
+                target_weight = candidate_weight;
+                queue.push({candidate_weight, target});
+            }
+        }
+    }
+}
+
+template <typename Weight>
+int ContractionHierarchyRouter<Weight>::ContractVertex(ContractionState& state, VertexId vertex,
+                                                       bool simulate) {
+    const auto in_neighbours = CollectNeighbours(state, vertex, false);
+    const auto out_neighbours = CollectNeighbours(state, vertex, true);
+
+    int shortcut_count = 0;
+    if (!in_neighbours.empty() && !out_neighbours.empty()) {
+        Weight max_out_weight = ZERO_WEIGHT;
+        for (const auto& out : out_neighbours) {
+            max_out_weight = std::max(max_out_weight, out.weight);
+        }
+
+        for (const auto& out : out_neighbours) {
+            state.witness_targets[out.vertex] = true;
+        }
+
+        for (const auto& in : in_neighbours) {
+            RunWitnessSearch(state, in.vertex, vertex, in.weight + max_out_weight, out_neighbours.size(),
+                             simulate ? SIMULATION_SETTLE_LIMIT : WITNESS_SETTLE_LIMIT);
+            for (const auto& out : out_neighbours) {
+                if (out.vertex == in.vertex) {
+                    continue;
+                }
+                const Weight shortcut_weight = in.weight + out.weight;
+                const auto& witness_weight = state.witness_weights[out.vertex];
+                if (witness_weight && !(shortcut_weight < *witness_weight)) {
+                    continue;
+                }
+
+                ++shortcut_count;
+                if (!simulate) {
+                    edges_.push_back({in.vertex, out.vertex, shortcut_weight, NO_EDGE, in.edge, out.edge});
+                    state.out_edges[in.vertex].push_back(edges_.size() - 1);
+                    state.in_edges[out.vertex].push_back(edges_.size() - 1);
+                }
+            }
+        }
+
+        for (const auto& out : out_neighbours) {
+            state.witness_targets[out.vertex] = false;
+        }
+    }
+
+    if (!simulate) {
+        // Рёбра к стянутой вершине больше не участвуют в поиске свидетелей
+        const auto is_incident = [this, vertex](size_t edge) {
+            return edges_[edge].from == vertex || edges_[edge].to == vertex;
+        };
+        for (const auto& in : in_neighbours) {
+            auto& out_edges = state.out_edges[in.vertex];
+            out_edges.erase(std::remove_if(out_edges.begin(), out_edges.end(), is_incident), out_edges.end());
+            ++state.deleted_neighbours[in.vertex];
+        }
+        for (const auto& out : out_neighbours) {
+            auto& in_edges = state.in_edges[out.vertex];
+            in_edges.erase(std::remove_if(in_edges.begin(), in_edges.end(), is_incident), in_edges.end());
+            ++state.deleted_neighbours[out.vertex];
+        }
+    }
+
+    return shortcut_count - static_cast<int>(in_neighbours.size() + out_neighbours.size())
+         + state.deleted_neighbours[vertex];
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::BuildSearchGraphs() {
+    std::vector<std::pair<EdgeId, Edge<Weight>>> upward_edges;
+    std::vector<std::pair<EdgeId, Edge<Weight>>> downward_edges;
+    for (size_t edge = 0; edge < edges_.size(); ++edge) {
+        const auto& hierarchy_edge = edges_[edge];
+        if (ranks_.at(hierarchy_edge.from) < ranks_.at(hierarchy_edge.to)) {
+            upward_edges.push_back({edge, {hierarchy_edge.from, hierarchy_edge.to, hierarchy_edge.weight}});
+        } else {
+            downward_edges.push_back({edge, {hierarchy_edge.to, hierarchy_edge.from, hierarchy_edge.weight}});
+        }
+    }
+    upward_graph_ = CompressedGraph<Weight>(ranks_.size(), upward_edges);
+    downward_graph_ = CompressedGraph<Weight>(ranks_.size(), downward_edges);
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::UnpackEdge(size_t edge, std::vector<EdgeId>& edges) const {
+    std::vector<size_t> stack{edge};
+    while (!stack.empty()) {
+        const auto& hierarchy_edge = edges_[stack.back()];
+        stack.pop_back();
+        if (hierarchy_edge.original_edge != NO_EDGE) {
+            edges.push_back(hierarchy_edge.original_edge);
+        } else {
+            stack.push_back(hierarchy_edge.upper_edge);
+            stack.push_back(hierarchy_edge.lower_edge);
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename ContractionHierarchyRouter<Weight>::RouteInfo>
+ContractionHierarchyRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    const size_t vertex_count = ranks_.size();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (from == to) {
+        return RouteInfo{ZERO_WEIGHT, {}};
+    }
+
+    // Рёбра путей в рабочих местах - индексы рёбер иерархии
+    using Workspace = SearchWorkspace<Weight>;
+    auto& forward = GetThreadWorkspace<Weight>(0);
+    auto& backward = GetThreadWorkspace<Weight>(1);
+    forward.Reset(vertex_count);
+    backward.Reset(vertex_count);
+    forward.Reach(from, ZERO_WEIGHT, Workspace::NO_EDGE);
+    backward.Reach(to, ZERO_WEIGHT, Workspace::NO_EDGE);
+    forward.frontier.Push(ZERO_WEIGHT, from);
+    backward.frontier.Push(ZERO_WEIGHT, to);
+    SearchStats* const stats = GetThreadSearchStats();
+    if (stats) {
+        stats->heap_pushes += 2;
+    }
+
+    std::optional<Weight> best_weight;
+    VertexId meeting_vertex = from;
+
+    while (!forward.frontier.IsEmpty() || !backward.frontier.IsEmpty()) {
+        const bool is_forward = backward.frontier.IsEmpty()
+            || (!forward.frontier.IsEmpty() && !(backward.frontier.Top().weight < forward.frontier.Top().weight));
+        Workspace& workspace = is_forward ? forward : backward;
+        const Workspace& other_workspace = is_forward ? backward : forward;
+        auto& frontier = workspace.frontier;
+
+        const auto [weight, vertex] = frontier.Pop();
+        if (stats) {
+            ++stats->heap_pops;
+        }
+        if (best_weight && !(weight < *best_weight)) {
+            frontier.Clear();
+            continue;
+        }
+        if (workspace.GetWeight(vertex) < weight) {
+            continue;
+        }
+        if (stats) {
+            ++stats->settled_vertices;
+        }
+
+        if (other_workspace.IsReached(vertex) &&
+            (!best_weight || weight + other_workspace.GetWeight(vertex) < *best_weight)) {
+            best_weight = weight + other_workspace.GetWeight(vertex);
+            meeting_vertex = vertex;
+        }
+
+        const auto& search_graph = is_forward ? upward_graph_ : downward_graph_;
+        const size_t edges_begin = search_graph.GetFirstEdge(vertex);
+        const size_t edges_end = search_graph.GetFirstEdge(vertex + 1);
+        if (stats) {
+            stats->relaxed_edges += edges_end - edges_begin;
+        }
+        for (size_t position = edges_begin; position < edges_end; ++position) {
+            const VertexId next = search_graph.GetEdgeTarget(position);
+            const Weight candidate_weight = weight + search_graph.GetEdgeWeight(position);
+            if (!workspace.IsReached(next) || candidate_weight < workspace.GetWeight(next)) {
+                workspace.Reach(next, candidate_weight, search_graph.GetEdgeId(position));
+                frontier.Push(candidate_weight, next);
+                if (stats) {
+                    ++stats->heap_pushes;
+                }
+            }
+        }
+    }
+    MarkSearchFinished(stats);
+
+    if (!best_weight) {
+        return std::nullopt;
+    }
+
+    std::vector<size_t> hierarchy_path;
+    for (VertexId vertex = meeting_vertex; forward.GetPrevEdge(vertex) != Workspace::NO_EDGE;
+         vertex = edges_[forward.GetPrevEdge(vertex)].from) {
+        hierarchy_path.push_back(forward.GetPrevEdge(vertex));
+    }
+    std::reverse(hierarchy_path.begin(), hierarchy_path.end());
+    for (VertexId vertex = meeting_vertex; backward.GetPrevEdge(vertex) != Workspace::NO_EDGE;
+         vertex = edges_[backward.GetPrevEdge(vertex)].to) {
+        hierarchy_path.push_back(backward.GetPrevEdge(vertex));
+    }
+
+    std::vector<EdgeId> edges;
+    for (const size_t edge : hierarchy_path) {
+        UnpackEdge(edge, edges);
+    }
+
+    // Вес пересчитывается по исходным рёбрам в порядке пути, чтобы округление совпадало
+    // с остальными способами поиска, а не зависело от порядка сложения в сокращениях
+    Weight weight = ZERO_WEIGHT;
+    for (const EdgeId edge_id : edges) {
+        weight = weight + graph_.GetEdge(edge_id).weight;
+    }
+
+    return RouteInfo{weight, std::move(edges)};
+}
+
+}  // namespace graph
@@ -0,0 +1,288 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "search_workspace.h"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+template <typename Weight>
+class DijkstraRouter : public RouterBase<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+    using Endpoint = typename RouterBase<Weight>::Endpoint;
+    using BestRouteInfo = typename RouterBase<Weight>::BestRouteInfo;
+
+    explicit DijkstraRouter(const Graph& graph);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    std::optional<Weight> BuildRouteInto(VertexId from, VertexId to, std::vector<EdgeId>& edges) const override;
+    std::vector<std::optional<RouteInfo>> BuildRoutesFrom(VertexId from,
+                                                          const std::vector<VertexId>& targets) const override;
+    // Один поиск сразу из всех источников: начальный вес источника равен его добавке
+    std::optional<BestRouteInfo> BuildBestRoute(const std::vector<Endpoint>& sources,
+                                                const std::vector<Endpoint>& targets,
+                                                std::vector<EdgeId>& edges) const override;
+
+private:
+    using Workspace = SearchWorkspace<Weight>;
+
+    void Search(VertexId from, const std::vector<VertexId>& targets, Workspace& workspace) const;
+    // Рёбра маршрута до осевшей вершины to записываются в edges, возвращается вес маршрута
+    std::optional<Weight> ExtractRoute(const Workspace& workspace, VertexId to, std::vector<EdgeId>& edges) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+    CompressedGraph<Weight> compressed_graph_;
+};
+
+template <typename Weight>
+DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph)
+    : graph_(graph)
+    , compressed_graph_(graph)
+{
+    const size_t edge_count = graph.GetEdgeCount();
+    for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+}
+
+template <typename Weight>
+void DijkstraRouter<Weight>::Search(VertexId from, const std::vector<VertexId>& targets, Workspace& workspace) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    workspace.Reset(vertex_count);
+
+    // Поиск останавливается, как только осели все целевые вершины
+    size_t targets_left = 0;
+    for (const VertexId to : targets) {
+        if (to >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        if (!workspace.IsTarget(to)) {
+            workspace.MarkTarget(to);
+            ++targets_left;
+        }
+    }
+    // Без целей искать нечего: иначе поиск обошёл бы всю компоненту
+    if (targets_left == 0) {
+        return;
+    }
+
+    SearchStats* const stats = GetThreadSearchStats();
+    auto& frontier = workspace.frontier;
+    workspace.Reach(from, ZERO_WEIGHT, Workspace::NO_EDGE);
+    frontier.Push(ZERO_WEIGHT, from);
+    if (stats) {
+        ++stats->heap_pushes;
+    }
+
+    while (!frontier.IsEmpty()) {
+        const auto [weight, vertex] = frontier.Pop();
+        if (stats) {
+            ++stats->heap_pops;
+        }
+        if (workspace.IsSettled(vertex)) {
+            continue;
+        }
+        workspace.Settle(vertex);
+        if (stats) {
+            ++stats->settled_vertices;
+        }
+        if (workspace.IsTarget(vertex) && --targets_left == 0) {
+            break;
+        }
+
+        const size_t edges_begin = compressed_graph_.GetFirstEdge(vertex);
+        const size_t edges_end = compressed_graph_.GetFirstEdge(vertex + 1);
+        if (stats) {
+            stats->relaxed_edges += edges_end - edges_begin;
+        }
+        for (size_t position = edges_begin; position < edges_end; ++position) {
+            const VertexId target = compressed_graph_.GetEdgeTarget(position);
+            const Weight candidate_weight = weight + compressed_graph_.GetEdgeWeight(position);
+            if (!workspace.IsReached(target) || candidate_weight < workspace.GetWeight(target)) {
+                workspace.Reach(target, candidate_weight, compressed_graph_.GetEdgeId(position));
+                frontier.Push(candidate_weight, target);
+                if (stats) {
+                    ++stats->heap_pushes;
+                }
+            }
+        }
+    }
+    MarkSearchFinished(stats);
+}
+
+template <typename Weight>
+std::optional<Weight> DijkstraRouter<Weight>::ExtractRoute(const Workspace& workspace, VertexId to,
+                                                           std::vector<EdgeId>& edges) const {
+    edges.clear();
+    if (!workspace.IsSettled(to)) {
+        return std::nullopt;
+    }
+
+    for (EdgeId edge_id = workspace.GetPrevEdge(to);
+         edge_id != Workspace::NO_EDGE;
+         edge_id = workspace.GetPrevEdge(graph_.GetEdge(edge_id).from))
+    {
+        edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return workspace.GetWeight(to);
+}
+
+template <typename Weight>
+std::optional<Weight> DijkstraRouter<Weight>::BuildRouteInto(VertexId from, VertexId to,
+                                                             std::vector<EdgeId>& edges) const {
+    auto& workspace = GetThreadWorkspace<Weight>();
+    Search(from, {to}, workspace);
+    return ExtractRoute(workspace, to, edges);
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(
+    VertexId from, VertexId to) const {
+    RouteInfo route;
+    const auto weight = BuildRouteInto(from, to, route.edges);
+    if (!weight) {
+        return std::nullopt;
+    }
+    route.weight = *weight;
+    return route;
+}
+
+template <typename Weight>
+std::vector<std::optional<typename DijkstraRouter<Weight>::RouteInfo>> DijkstraRouter<Weight>::BuildRoutesFrom(
+    VertexId from, const std::vector<VertexId>& targets) const {
+    auto& workspace = GetThreadWorkspace<Weight>();
+    Search(from, targets, workspace);
+
+    std::vector<std::optional<RouteInfo>> routes;
+    routes.reserve(targets.size());
+    for (const VertexId to : targets) {
+        RouteInfo route;
+        if (const auto weight = ExtractRoute(workspace, to, route.edges)) {
+            route.weight = *weight;
+            routes.push_back(std::move(route));
+        } else {
+            routes.push_back(std::nullopt);
+        }
+    }
+    return routes;
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::BestRouteInfo> DijkstraRouter<Weight>::BuildBestRoute(
+    const std::vector<Endpoint>& sources, const std::vector<Endpoint>& targets, std::vector<EdgeId>& edges) const {
+    edges.clear();
+    const size_t vertex_count = graph_.GetVertexCount();
+    auto& workspace = GetThreadWorkspace<Weight>();
+    workspace.Reset(vertex_count);
+    auto& frontier = workspace.frontier;
+    SearchStats* const stats = GetThreadSearchStats();
+
+    for (const auto& [vertex, extra_weight] : sources) {
+        if (vertex >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        if (!workspace.IsReached(vertex) || extra_weight < workspace.GetWeight(vertex)) {
+            workspace.Reach(vertex, extra_weight, Workspace::NO_EDGE);
+            frontier.Push(extra_weight, vertex);
+            if (stats) {
+                ++stats->heap_pushes;
+            }
+        }
+    }
+    for (const auto& [vertex, extra_weight] : targets) {
+        if (vertex >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        workspace.MarkTarget(vertex);
+    }
+
+    // Добавки неотрицательны, поэтому после извлечения веса не меньше лучшего итога улучшений не будет
+    std::optional<BestRouteInfo> best;
+    VertexId best_vertex = 0;
+    while (!frontier.IsEmpty()) {
+        const auto [weight, vertex] = frontier.Pop();
+        if (stats) {
+            ++stats->heap_pops;
+        }
+        if (best && !(weight < best->weight)) {
+            break;
+        }
+        if (workspace.IsSettled(vertex)) {
+            continue;
+        }
+        workspace.Settle(vertex);
+        if (stats) {
+            ++stats->settled_vertices;
+        }
+        if (workspace.IsTarget(vertex)) {
+            for (size_t target_index = 0; target_index < targets.size(); ++target_index) {
+                const Weight total_weight = weight + targets[target_index].extra_weight;
+                if (targets[target_index].vertex == vertex && (!best || total_weight < best->weight)) {
+                    best = BestRouteInfo{total_weight, 0, target_index};
+                    best_vertex = vertex;
+                }
+            }
+        }
+
+        const size_t edges_begin = compressed_graph_.GetFirstEdge(vertex);
+        const size_t edges_end = compressed_graph_.GetFirstEdge(vertex + 1);
+        if (stats) {
+            stats->relaxed_edges += edges_end - edges_begin;
+        }
+        for (size_t position = edges_begin; position < edges_end; ++position) {
+            const VertexId target = compressed_graph_.GetEdgeTarget(position);
+            const Weight candidate_weight = weight + compressed_graph_.GetEdgeWeight(position);
+            if (!workspace.IsReached(target) || candidate_weight < workspace.GetWeight(target)) {
+                workspace.Reach(target, candidate_weight, compressed_graph_.GetEdgeId(position));
+                frontier.Push(candidate_weight, target);
+                if (stats) {
+                    ++stats->heap_pushes;
+                }
+            }
+        }
+    }
+    MarkSearchFinished(stats);
+    if (!best) {
+        return std::nullopt;
+    }
+
+    VertexId root = best_vertex;
+    for (EdgeId edge_id = workspace.GetPrevEdge(root); edge_id != Workspace::NO_EDGE;
+         edge_id = workspace.GetPrevEdge(root)) {
+        edges.push_back(edge_id);
+        root = graph_.GetEdge(edge_id).from;
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    // Корень пути - источник, с добавкой которого он был достигнут
+    for (size_t source_index = 0; source_index < sources.size(); ++source_index) {
+        if (sources[source_index].vertex == root
+            && !(workspace.GetWeight(root) < sources[source_index].extra_weight)) {
+            best->source_index = source_index;
+            break;
+        }
+    }
+    return best;
+}
+
+}  // namespace graph
@@ -1,9 +1,10 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
+#include <optional>
 #include <utility>
-#include <variant>
 
 #include "geo.h"
 
@@ -35,31 +36,55 @@ namespace transport_catalogue
         double curvature;
     };
 
-    struct PathDataItemBus
+    // Вершины графа маршрутов: остановка с индексом i в справочнике получает id = 2 * i
+    inline uint32_t GetStopIndex(const Stop &stop)
     {
-        PathDataItemBus(std::string_view name, int span_count, double time)
-            : name(name), span_count(span_count), time(time) {}
+        return static_cast<uint32_t>(stop.id / 2);
+    }
 
-        std::string type = "Bus"s;
-        std::string_view name;
-        int span_count;
+    enum class RouteItemKind : uint8_t
+    {
+        WAIT,
+        BUS,
+        WALK,
+    };
+
+    // id пешего участка между двумя точками без остановки на конце
+    constexpr uint32_t NO_STOP_INDEX = UINT32_MAX;
+
+    // Элемент маршрута без строк: id - индекс остановки (ожидание, пеший участок до остановки
+    // посадки или от остановки высадки) или автобуса (поездка) в справочнике, имена
+    // подставляются только при выводе ответа
+    struct RouteItem
+    {
+        RouteItemKind kind;
+        uint32_t id;
+        uint32_t span_count;
         double time;
     };
 
-    struct PathDataItemWait
+    // Результат поиска маршрута. Вызывающий переиспользует один объект между запросами,
+    // и после первых запросов items заполняется без выделения памяти
+    struct RouteResult
     {
-        PathDataItemWait(std::string_view stop_name, double time)
-            : stop_name(std::move(stop_name)), time(time) {}
+        double total_time = 0;
+        std::vector<RouteItem> items;
+    };
 
-        std::string type = "Wait"s;
-        std::string_view stop_name;
+    // Остановка из ответа Reachable: индекс в справочнике и наименьшее время в пути до неё
+    struct ReachableStop
+    {
+        uint32_t stop_index;
         double time;
     };
 
-    using PathDataItem = std::variant<PathDataItemBus, PathDataItemWait>;
-    struct PathData
+    // Ответ на RouteMatrix: ячейка (from, to) лежит по индексу from * to_count + to,
+    // списки элементов маршрутов заполняются только по запросу
+    struct RouteMatrixData
     {
-        double total_time = 0;
-        std::vector<PathDataItem> items;
+        size_t from_count = 0;
+        size_t to_count = 0;
+        std::vector<std::optional<double>> total_times;
+        std::vector<std::vector<RouteItem>> items;
     };
 } // namespace transport_catalogue
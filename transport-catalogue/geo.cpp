@@ -1,6 +1,7 @@
 #define _USE_MATH_DEFINES
 #include "geo.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace geo
@@ -18,4 +19,14 @@ namespace geo
         cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr)) * EARTH_RADIUS;
     }
 
+    double ComputeHaversineDistance(Coordinates from, Coordinates to)
+    {
+        using namespace std;
+        static const double dr = M_PI / 180.;
+        const double lat_sin = sin((to.lat - from.lat) * dr / 2);
+        const double lng_sin = sin((to.lng - from.lng) * dr / 2);
+        const double haversine = lat_sin * lat_sin + cos(from.lat * dr) * cos(to.lat * dr) * lng_sin * lng_sin;
+        return 2 * asin(sqrt(min(1.0, haversine))) * EARTH_RADIUS;
+    }
+
 } // namespace geo
\ No newline at end of file
@@ -21,4 +21,7 @@ namespace geo
     };
 
     double ComputeDistance(Coordinates from, Coordinates to);
+    // То же расстояние по дуге, но по формуле гаверсинусов: её относительная погрешность
+    // порядка машинной и на малых расстояниях, где acos в ComputeDistance теряет точность
+    double ComputeHaversineDistance(Coordinates from, Coordinates to);
 }
\ No newline at end of file
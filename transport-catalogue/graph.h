@@ -3,6 +3,7 @@
 #include "ranges.h"
 
 #include <cstdlib>
+#include <utility>
 #include <vector>
 
 namespace graph {
@@ -27,6 +28,8 @@ public:
     DirectedWeightedGraph() = default;
     explicit DirectedWeightedGraph(size_t vertex_count);
     EdgeId AddEdge(const Edge<Weight>& edge);
+    // Меняет вес ребра, не затрагивая структуру графа
+    void SetEdgeWeight(EdgeId edge_id, Weight weight);
 
     size_t GetVertexCount() const;
     size_t GetEdgeCount() const;
@@ -51,6 +54,11 @@ EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
     return id;
 }
 
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::SetEdgeWeight(EdgeId edge_id, Weight weight) {
+    edges_.at(edge_id).weight = weight;
+}
+
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
     return incidence_lists_.size();
@@ -71,4 +79,86 @@ typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
 DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
     return ranges::AsRange(incidence_lists_.at(vertex));
 }
+
+// Замороженное представление графа в формате CSR: рёбра вершины v занимают позиции
+// [GetFirstEdge(v), GetFirstEdge(v + 1)) в непрерывных массивах целей и весов.
+// Доступ по позиции не проверяет границы и предназначен для горячих циклов поиска.
+template <typename Weight>
+class CompressedGraph {
+public:
+    CompressedGraph() = default;
+    explicit CompressedGraph(const DirectedWeightedGraph<Weight>& graph);
+    // Рёбра с произвольными идентификаторами, например рёбра иерархии сжатий
+    CompressedGraph(size_t vertex_count, const std::vector<std::pair<EdgeId, Edge<Weight>>>& edges);
+
+    size_t GetVertexCount() const {
+        return offsets_.size() - 1;
+    }
+    size_t GetEdgeCount() const {
+        return targets_.size();
+    }
+
+    size_t GetFirstEdge(VertexId vertex) const {
+        return offsets_[vertex];
+    }
+    VertexId GetEdgeTarget(size_t position) const {
+        return targets_[position];
+    }
+    Weight GetEdgeWeight(size_t position) const {
+        return weights_[position];
+    }
+    EdgeId GetEdgeId(size_t position) const {
+        return edge_ids_[position];
+    }
+
+private:
+    template <typename EdgeGetter>
+    void Build(size_t vertex_count, size_t edge_count, EdgeGetter get_edge);
+
+    std::vector<size_t> offsets_ = {0};
+    std::vector<VertexId> targets_;
+    std::vector<Weight> weights_;
+    std::vector<EdgeId> edge_ids_;
+};
+
+template <typename Weight>
+CompressedGraph<Weight>::CompressedGraph(const DirectedWeightedGraph<Weight>& graph) {
+    Build(graph.GetVertexCount(), graph.GetEdgeCount(), [&graph](size_t index) {
+        return std::pair<EdgeId, const Edge<Weight>&>{index, graph.GetEdge(index)};
+    });
+}
+
+template <typename Weight>
+CompressedGraph<Weight>::CompressedGraph(size_t vertex_count,
+                                         const std::vector<std::pair<EdgeId, Edge<Weight>>>& edges) {
+    Build(vertex_count, edges.size(), [&edges](size_t index) {
+        return std::pair<EdgeId, const Edge<Weight>&>{edges[index].first, edges[index].second};
+    });
+}
+
+template <typename Weight>
+template <typename EdgeGetter>
+void CompressedGraph<Weight>::Build(size_t vertex_count, size_t edge_count, EdgeGetter get_edge) {
+    offsets_.assign(vertex_count + 1, 0);
+    for (size_t index = 0; index < edge_count; ++index) {
+        ++offsets_.at(get_edge(index).second.from + 1);
+    }
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        offsets_[vertex + 1] += offsets_[vertex];
+    }
+
+    // Сортировка подсчётом сохраняет порядок рёбер внутри вершины
+    std::vector<size_t> positions(offsets_.begin(), offsets_.end() - 1);
+    targets_.resize(edge_count);
+    weights_.resize(edge_count);
+    edge_ids_.resize(edge_count);
+    for (size_t index = 0; index < edge_count; ++index) {
+        const auto [edge_id, edge] = get_edge(index);
+        const size_t position = positions[edge.from]++;
+        targets_[position] = edge.to;
+        weights_[position] = edge.weight;
+        edge_ids_[position] = edge_id;
+    }
+}
+
 }  // namespace graph
\ No newline at end of file
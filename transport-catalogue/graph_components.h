@@ -0,0 +1,139 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Метки компонент графа для мгновенного отказа в недостижимых маршрутах.
+// Сильные компоненты нумеруются алгоритмом Тарьяна в обратном топологическом порядке:
+// ребро между компонентами всегда ведёт к меньшему номеру, поэтому из компоненты с меньшим
+// номером в компоненту с большим пути нет. Слабые компоненты отсекают несвязанные части сети
+class ComponentLabels {
+public:
+    ComponentLabels() = default;
+    template <typename Weight>
+    explicit ComponentLabels(const DirectedWeightedGraph<Weight>& graph);
+
+    // false - пути из from в to точно нет, true - путь возможен
+    bool MayReach(VertexId from, VertexId to) const {
+        return weak_components_[from] == weak_components_[to] &&
+               strong_components_[to] <= strong_components_[from];
+    }
+
+    size_t GetStrongComponentCount() const {
+        return strong_component_count_;
+    }
+
+private:
+    template <typename Weight>
+    void ComputeStrongComponents(const DirectedWeightedGraph<Weight>& graph);
+    template <typename Weight>
+    void ComputeWeakComponents(const DirectedWeightedGraph<Weight>& graph);
+
+    std::vector<uint32_t> strong_components_;
+    std::vector<uint32_t> weak_components_;
+    size_t strong_component_count_ = 0;
+};
+
+template <typename Weight>
+ComponentLabels::ComponentLabels(const DirectedWeightedGraph<Weight>& graph) {
+    ComputeStrongComponents(graph);
+    ComputeWeakComponents(graph);
+}
+
+template <typename Weight>
+void ComponentLabels::ComputeStrongComponents(const DirectedWeightedGraph<Weight>& graph) {
+    static constexpr uint32_t NOT_VISITED = std::numeric_limits<uint32_t>::max();
+    const size_t vertex_count = graph.GetVertexCount();
+
+    // Тарьян без рекурсии: стек вызовов хранит вершину и позицию в списке её рёбер
+    std::vector<uint32_t> indexes(vertex_count, NOT_VISITED);
+    std::vector<uint32_t> low_links(vertex_count, 0);
+    std::vector<bool> on_stack(vertex_count, false);
+    std::vector<VertexId> stack;
+    std::vector<std::pair<VertexId, size_t>> call_stack;
+    strong_components_.assign(vertex_count, 0);
+    uint32_t next_index = 0;
+
+    for (VertexId root = 0; root < vertex_count; ++root) {
+        if (indexes[root] != NOT_VISITED) {
+            continue;
+        }
+        call_stack.push_back({root, 0});
+        while (!call_stack.empty()) {
+            auto& [vertex, edge_position] = call_stack.back();
+            if (edge_position == 0 && indexes[vertex] == NOT_VISITED) {
+                indexes[vertex] = low_links[vertex] = next_index++;
+                stack.push_back(vertex);
+                on_stack[vertex] = true;
+            }
+
+            const auto edges = graph.GetIncidentEdges(vertex);
+            if (edge_position < static_cast<size_t>(edges.end() - edges.begin())) {
+                const VertexId target = graph.GetEdge(*(edges.begin() + edge_position)).to;
+                ++edge_position;
+                if (indexes[target] == NOT_VISITED) {
+                    call_stack.push_back({target, 0});
+                } else if (on_stack[target]) {
+                    low_links[vertex] = std::min(low_links[vertex], indexes[target]);
+                }
+                continue;
+            }
+
+            const VertexId finished = vertex;
+            call_stack.pop_back();
+            if (!call_stack.empty()) {
+                const VertexId parent = call_stack.back().first;
+                low_links[parent] = std::min(low_links[parent], low_links[finished]);
+            }
+            if (low_links[finished] == indexes[finished]) {
+                VertexId member;
+                do {
+                    member = stack.back();
+                    stack.pop_back();
+                    on_stack[member] = false;
+                    strong_components_[member] = static_cast<uint32_t>(strong_component_count_);
+                } while (member != finished);
+                ++strong_component_count_;
+            }
+        }
+    }
+}
+
+template <typename Weight>
+void ComponentLabels::ComputeWeakComponents(const DirectedWeightedGraph<Weight>& graph) {
+    const size_t vertex_count = graph.GetVertexCount();
+    std::vector<VertexId> parents(vertex_count);
+    std::iota(parents.begin(), parents.end(), 0);
+    const auto find_root = [&parents](VertexId vertex) {
+        while (parents[vertex] != vertex) {
+            parents[vertex] = parents[parents[vertex]];
+            vertex = parents[vertex];
+        }
+        return vertex;
+    };
+
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        const VertexId from_root = find_root(edge.from);
+        const VertexId to_root = find_root(edge.to);
+        if (from_root != to_root) {
+            parents[std::max(from_root, to_root)] = std::min(from_root, to_root);
+        }
+    }
+
+    weak_components_.resize(vertex_count);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        weak_components_[vertex] = static_cast<uint32_t>(find_root(vertex));
+    }
+}
+
+}  // namespace graph
@@ -0,0 +1,396 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "dijkstra_router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Разметка хабами (2-hop cover): у каждой вершины v есть прямая метка - хабы h с весом пути
+// v -> h, и обратная - хабы h с весом пути h -> v. Любой кратчайший путь u -> v проходит через
+// общий хаб меток, поэтому его вес - минимум по слиянию двух коротких отсортированных массивов.
+// Метки строятся усечёнными поисками Дейкстры в порядке убывания степени вершин (pruned landmark
+// labeling). Запись метки хранит ребро дерева поиска хаба, поэтому маршрут восстанавливается
+// проходом по меткам от концов к общему хабу без перебора соседей
+template <typename Weight>
+class HubLabelRouter : public RouterBase<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+    static constexpr Weight NO_DISTANCE = std::numeric_limits<Weight>::infinity();
+
+    struct LabelEntry {
+        // Порядковый номер хаба при построении, по нему отсортированы метки
+        uint32_t hub;
+        Weight weight;
+        // Прямая метка - первое ребро пути v -> h, обратная - последнее ребро пути h -> v;
+        // NO_EDGE у самого хаба
+        uint32_t edge;
+    };
+
+    static constexpr uint32_t NO_EDGE = std::numeric_limits<uint32_t>::max();
+
+    // Метки всех вершин подряд: метка вершины v - entries[offsets[v]..offsets[v + 1])
+    struct Labels {
+        std::vector<size_t> offsets;
+        std::vector<LabelEntry> entries;
+    };
+
+    explicit HubLabelRouter(const Graph& graph);
+    HubLabelRouter(const Graph& graph, Labels forward_labels, Labels backward_labels);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    std::optional<Weight> GetRouteWeight(VertexId from, VertexId to) const override;
+
+    const Labels& GetForwardLabels() const;
+    const Labels& GetBackwardLabels() const;
+
+private:
+    struct QueueItem {
+        Weight weight;
+        VertexId vertex;
+
+        bool operator>(const QueueItem& other) const {
+            return other.weight < weight;
+        }
+    };
+
+    struct HubMatch {
+        Weight weight;
+        uint32_t hub;
+    };
+
+    using LabelsBuffer = std::vector<std::vector<LabelEntry>>;
+
+    void CheckWeights() const;
+    void BuildLabels();
+    // Усечённый поиск из хаба vertex с номером hub: вершина, для которой метки уже дают
+    // путь не тяжелее найденного, не получает новую запись и не раскрывается
+    void PrunedSearch(const CompressedGraph<Weight>& graph, VertexId vertex, uint32_t hub,
+                      const std::vector<LabelEntry>& hub_label, LabelsBuffer& labels,
+                      std::vector<Weight>& hub_weights, std::vector<Weight>& weights,
+                      std::vector<uint32_t>& parent_edges) const;
+    static Labels Flatten(LabelsBuffer labels);
+    HubMatch Query(VertexId from, VertexId to) const;
+    static const LabelEntry* FindEntry(const Labels& labels, VertexId vertex, uint32_t hub);
+    // Дописывает в route рёбра пути от вершины до хаба по меткам labels; false, если метки не сходятся
+    bool AppendLabelPath(const Labels& labels, VertexId vertex, uint32_t hub, bool forward, RouteInfo& route) const;
+    void CheckLabels(const Labels& labels, bool forward) const;
+    const DijkstraRouter<Weight>& GetFallbackRouter() const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+    CompressedGraph<Weight> compressed_graph_;
+    Labels forward_labels_;
+    Labels backward_labels_;
+    // Запасной поиск строится один раз при первой надобности и дальше переиспользуется
+    mutable std::once_flag fallback_router_built_;
+    mutable std::unique_ptr<DijkstraRouter<Weight>> fallback_router_ptr_;
+};
+
+template <typename Weight>
+HubLabelRouter<Weight>::HubLabelRouter(const Graph& graph)
+    : graph_(graph)
+    , compressed_graph_(graph)
+{
+    CheckWeights();
+    BuildLabels();
+}
+
+template <typename Weight>
+HubLabelRouter<Weight>::HubLabelRouter(const Graph& graph, Labels forward_labels, Labels backward_labels)
+    : graph_(graph)
+    , compressed_graph_(graph)
+    , forward_labels_(std::move(forward_labels))
+    , backward_labels_(std::move(backward_labels))
+{
+    CheckWeights();
+    CheckLabels(forward_labels_, true);
+    CheckLabels(backward_labels_, false);
+}
+
+template <typename Weight>
+const typename HubLabelRouter<Weight>::Labels& HubLabelRouter<Weight>::GetForwardLabels() const {
+    return forward_labels_;
+}
+
+template <typename Weight>
+const typename HubLabelRouter<Weight>::Labels& HubLabelRouter<Weight>::GetBackwardLabels() const {
+    return backward_labels_;
+}
+
+template <typename Weight>
+void HubLabelRouter<Weight>::CheckWeights() const {
+    const size_t edge_count = graph_.GetEdgeCount();
+    for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+        if (graph_.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+}
+
+template <typename Weight>
+void HubLabelRouter<Weight>::CheckLabels(const Labels& labels, bool forward) const {
+    if (labels.offsets.size() != graph_.GetVertexCount() + 1 || labels.offsets.front() != 0 ||
+        labels.offsets.back() != labels.entries.size() ||
+        !std::is_sorted(labels.offsets.begin(), labels.offsets.end())) {
+        throw std::invalid_argument("Hub labels don't match the graph");
+    }
+    for (VertexId vertex = 0; vertex < graph_.GetVertexCount(); ++vertex) {
+        const size_t label_end = labels.offsets[vertex + 1];
+        for (size_t position = labels.offsets[vertex]; position < label_end; ++position) {
+            const auto& entry = labels.entries[position];
+            if (entry.hub >= graph_.GetVertexCount()) {
+                throw std::invalid_argument("Hub labels don't match the graph");
+            }
+            // Слияние меток в Query опирается на строгий порядок хабов внутри метки
+            if (position > labels.offsets[vertex] && !(labels.entries[position - 1].hub < entry.hub)) {
+                throw std::invalid_argument("Hub labels aren't sorted by hub");
+            }
+            if (entry.edge == NO_EDGE) {
+                continue;
+            }
+            if (entry.edge >= graph_.GetEdgeCount()) {
+                throw std::invalid_argument("Hub labels don't match the graph");
+            }
+            const auto& edge = graph_.GetEdge(entry.edge);
+            if ((forward ? edge.from : edge.to) != vertex) {
+                throw std::invalid_argument("Hub labels don't match the graph");
+            }
+        }
+    }
+}
+
+template <typename Weight>
+void HubLabelRouter<Weight>::PrunedSearch(const CompressedGraph<Weight>& graph, VertexId vertex, uint32_t hub,
+                                          const std::vector<LabelEntry>& hub_label, LabelsBuffer& labels,
+                                          std::vector<Weight>& hub_weights, std::vector<Weight>& weights,
+                                          std::vector<uint32_t>& parent_edges) const {
+    for (const auto& entry : hub_label) {
+        hub_weights[entry.hub] = entry.weight;
+    }
+
+    std::vector<VertexId> touched_vertices{vertex};
+    std::vector<QueueItem> queue{{ZERO_WEIGHT, vertex}};
+    weights[vertex] = ZERO_WEIGHT;
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end(), std::greater<QueueItem>());
+        const auto [weight, current] = queue.back();
+        queue.pop_back();
+        if (weights[current] < weight) {
+            continue;
+        }
+
+        bool covered = false;
+        for (const auto& entry : labels[current]) {
+            if (hub_weights[entry.hub] != NO_DISTANCE && !(weight < hub_weights[entry.hub] + entry.weight)) {
+                covered = true;
+                break;
+            }
+        }
+        if (covered) {
+            continue;
+        }
+        labels[current].push_back({hub, weight, parent_edges[current]});
+
+        const size_t edges_end = graph.GetFirstEdge(current + 1);
+        for (size_t position = graph.GetFirstEdge(current); position < edges_end; ++position) {
+            const VertexId target = graph.GetEdgeTarget(position);
+            const Weight candidate_weight = weight + graph.GetEdgeWeight(position);
+            if (candidate_weight < weights[target]) {
+                if (weights[target] == NO_DISTANCE) {
+                    touched_vertices.push_back(target);
+                }
+                weights[target] = candidate_weight;
+                parent_edges[target] = static_cast<uint32_t>(graph.GetEdgeId(position));
+                queue.push_back({candidate_weight, target});
+                std::push_heap(queue.begin(), queue.end(), std::greater<QueueItem>());
+            }
+        }
+    }
+
+    for (const VertexId touched : touched_vertices) {
+        weights[touched] = NO_DISTANCE;
+        parent_edges[touched] = NO_EDGE;
+    }
+    for (const auto& entry : hub_label) {
+        hub_weights[entry.hub] = NO_DISTANCE;
+    }
+}
+
+template <typename Weight>
+void HubLabelRouter<Weight>::BuildLabels() {
+    const size_t vertex_count = graph_.GetVertexCount();
+
+    std::vector<std::pair<EdgeId, Edge<Weight>>> reversed_edges;
+    reversed_edges.reserve(graph_.GetEdgeCount());
+    std::vector<size_t> degrees(vertex_count, 0);
+    for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph_.GetEdge(edge_id);
+        reversed_edges.push_back({edge_id, {edge.to, edge.from, edge.weight}});
+        ++degrees[edge.from];
+        ++degrees[edge.to];
+    }
+    const CompressedGraph<Weight> reversed_graph(vertex_count, reversed_edges);
+
+    // Через вершины с большой степенью проходит больше кратчайших путей, они становятся хабами раньше
+    std::vector<VertexId> order(vertex_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&degrees](VertexId lhs, VertexId rhs) {
+        return degrees[lhs] > degrees[rhs];
+    });
+
+    LabelsBuffer forward_labels(vertex_count);
+    LabelsBuffer backward_labels(vertex_count);
+    std::vector<Weight> hub_weights(vertex_count, NO_DISTANCE);
+    std::vector<Weight> weights(vertex_count, NO_DISTANCE);
+    std::vector<uint32_t> parent_edges(vertex_count, NO_EDGE);
+    for (uint32_t hub = 0; hub < vertex_count; ++hub) {
+        const VertexId vertex = order[hub];
+        // Прямой поиск от хаба пополняет обратные метки, поиск по обращённому графу - прямые
+        PrunedSearch(compressed_graph_, vertex, hub, forward_labels[vertex], backward_labels, hub_weights, weights,
+                     parent_edges);
+        PrunedSearch(reversed_graph, vertex, hub, backward_labels[vertex], forward_labels, hub_weights, weights,
+                     parent_edges);
+    }
+
+    forward_labels_ = Flatten(std::move(forward_labels));
+    backward_labels_ = Flatten(std::move(backward_labels));
+}
+
+template <typename Weight>
+typename HubLabelRouter<Weight>::Labels HubLabelRouter<Weight>::Flatten(LabelsBuffer labels) {
+    Labels res;
+    res.offsets.reserve(labels.size() + 1);
+    res.offsets.push_back(0);
+    for (const auto& label : labels) {
+        res.offsets.push_back(res.offsets.back() + label.size());
+    }
+    res.entries.reserve(res.offsets.back());
+    for (auto& label : labels) {
+        res.entries.insert(res.entries.end(), label.begin(), label.end());
+        label = {};
+    }
+    return res;
+}
+
+template <typename Weight>
+typename HubLabelRouter<Weight>::HubMatch HubLabelRouter<Weight>::Query(VertexId from, VertexId to) const {
+    auto forward = forward_labels_.entries.begin() + forward_labels_.offsets[from];
+    const auto forward_end = forward_labels_.entries.begin() + forward_labels_.offsets[from + 1];
+    auto backward = backward_labels_.entries.begin() + backward_labels_.offsets[to];
+    const auto backward_end = backward_labels_.entries.begin() + backward_labels_.offsets[to + 1];
+
+    HubMatch res{NO_DISTANCE, 0};
+    while (forward != forward_end && backward != backward_end) {
+        if (forward->hub < backward->hub) {
+            ++forward;
+        } else if (backward->hub < forward->hub) {
+            ++backward;
+        } else {
+            if (forward->weight + backward->weight < res.weight) {
+                res = {forward->weight + backward->weight, forward->hub};
+            }
+            ++forward;
+            ++backward;
+        }
+    }
+    return res;
+}
+
+template <typename Weight>
+std::optional<Weight> HubLabelRouter<Weight>::GetRouteWeight(VertexId from, VertexId to) const {
+    if (from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    const Weight weight = Query(from, to).weight;
+    if (weight == NO_DISTANCE) {
+        return std::nullopt;
+    }
+    return weight;
+}
+
+template <typename Weight>
+const DijkstraRouter<Weight>& HubLabelRouter<Weight>::GetFallbackRouter() const {
+    std::call_once(fallback_router_built_, [this] {
+        fallback_router_ptr_ = std::make_unique<DijkstraRouter<Weight>>(graph_);
+    });
+    return *fallback_router_ptr_;
+}
+
+template <typename Weight>
+const typename HubLabelRouter<Weight>::LabelEntry* HubLabelRouter<Weight>::FindEntry(const Labels& labels,
+                                                                                    VertexId vertex, uint32_t hub) {
+    const auto label_begin = labels.entries.begin() + labels.offsets[vertex];
+    const auto label_end = labels.entries.begin() + labels.offsets[vertex + 1];
+    const auto it = std::lower_bound(label_begin, label_end, hub, [](const LabelEntry& entry, uint32_t value) {
+        return entry.hub < value;
+    });
+    if (it == label_end || it->hub != hub) {
+        return nullptr;
+    }
+    return &*it;
+}
+
+template <typename Weight>
+bool HubLabelRouter<Weight>::AppendLabelPath(const Labels& labels, VertexId vertex, uint32_t hub, bool forward,
+                                             RouteInfo& route) const {
+    // Вершина пути к хабу лежит в дереве его усечённого поиска, значит, тоже помечена этим хабом.
+    // Шагов больше числа вершин бывает только у испорченных меток
+    for (size_t steps = 0; steps <= graph_.GetVertexCount(); ++steps) {
+        const LabelEntry* entry = FindEntry(labels, vertex, hub);
+        if (!entry) {
+            return false;
+        }
+        if (entry->edge == NO_EDGE) {
+            return true;
+        }
+        const auto& edge = graph_.GetEdge(entry->edge);
+        route.weight += edge.weight;
+        route.edges.push_back(entry->edge);
+        vertex = forward ? edge.to : edge.from;
+    }
+    return false;
+}
+
+template <typename Weight>
+std::optional<typename HubLabelRouter<Weight>::RouteInfo> HubLabelRouter<Weight>::BuildRoute(VertexId from,
+                                                                                             VertexId to) const {
+    if (from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    const HubMatch match = Query(from, to);
+    MarkSearchFinished(GetThreadSearchStats());
+    if (match.weight == NO_DISTANCE) {
+        return std::nullopt;
+    }
+
+    // Начало маршрута - по прямым меткам до хаба, конец - по обратным от to к хабу с разворотом
+    RouteInfo route{ZERO_WEIGHT, {}};
+    if (!AppendLabelPath(forward_labels_, from, match.hub, true, route)) {
+        return GetFallbackRouter().BuildRoute(from, to);
+    }
+    const size_t forward_edge_count = route.edges.size();
+    if (!AppendLabelPath(backward_labels_, to, match.hub, false, route)) {
+        return GetFallbackRouter().BuildRoute(from, to);
+    }
+    std::reverse(route.edges.begin() + forward_edge_count, route.edges.end());
+    return route;
+}
+
+}  // namespace graph
@@ -142,11 +142,8 @@ namespace transport_catalogue
 
         void JsonReader::InputRoutingSettings()
         {
-            Dict routing_settings = doc_.value().GetRoot().AsDict().at("routing_settings"s).AsDict();
-
-            router::RoutingSettings rs;
-            rs.bus_wait_time = routing_settings.at("bus_wait_time").AsDouble();
-            rs.bus_velocity = routing_settings.at("bus_velocity").AsDouble();
+            router::RoutingSettings rs = detail::ParseRoutingSettings(
+                doc_.value().GetRoot().AsDict().at("routing_settings"s).AsDict());
 
             req_handler_.SetRoutingSettings(rs);
         }
@@ -159,6 +156,9 @@ namespace transport_catalogue
                                         .EndArray()
                                         .Build()
                                         .AsArray();
+            // Буферы ответов переиспользуются всеми запросами Route и Reachable
+            RouteResult route;
+            vector<ReachableStop> reachable_stops;
 
             for (const auto &node : stat_requests)
             {
@@ -255,48 +255,84 @@ namespace transport_catalogue
                 else if (type == "Route"s)
                 {
                     const auto &route_req_data = node.AsDict();
+                    const Node &from_node = route_req_data.at("from"s);
+                    const Node &to_node = route_req_data.at("to"s);
+                    // Без элементов маршрута ("items": false) маршрутизатор может ответить одним временем
+                    const bool with_items = route_req_data.count("items"s) == 0 || route_req_data.at("items"s).AsBool();
+                    // "explain": true добавляет к ответу разбор поиска по названиям остановок
+                    const bool explain = route_req_data.count("explain"s) != 0 && route_req_data.at("explain"s).AsBool();
+
+                    optional<double> total_time;
+                    router::RouteExplanation explanation;
+                    if (from_node.IsDict() || to_node.IsDict())
+                    {
+                        // Точка {"latitude", "longitude"} вместо названия остановки хотя бы в одном конце:
+                        // маршрут с пешими участками
+                        if (req_handler_.GetRouteBetweenPoints(detail::ParseRoutePoint(from_node),
+                                                               detail::ParseRoutePoint(to_node), route,
+                                                               explain ? &explanation : nullptr))
+                            total_time = route.total_time;
+                    }
+                    else if (explain)
+                    {
+                        if (req_handler_.ExplainShortWayBetween(from_node.AsString(), to_node.AsString(), route,
+                                                                explanation))
+                            total_time = route.total_time;
+                    }
+                    else if (!with_items)
+                        total_time = req_handler_.GetRouteTime(from_node.AsString(), to_node.AsString());
+                    else if (req_handler_.GetShortWayBetween(from_node.AsString(), to_node.AsString(), route))
+                        total_time = route.total_time;
+
+                    if (total_time.has_value())
+                    {
+                        Dict response{{"request_id"s, route_req_data.at("id"s).AsInt()},
+                                      {"total_time"s, *total_time}};
+                        if (with_items)
+                        {
+                            Array items(route.items.size());
+                            transform(route.items.begin(), route.items.end(), items.begin(),
+                                      [this](const RouteItem &item)
+                                      { return detail::RouteItemToDict(item, db_); });
+                            response.insert({"items"s, move(items)});
+                        }
+                        if (!explanation.router.empty())
+                            response.insert({"explain"s, detail::RouteExplanationToDict(explanation)});
+
+                        responses_array.push_back(move(response));
+                    }
+                    else
+                    {
+                        // Разбор есть и у ненайденного маршрута, если обе остановки существуют
+                        Dict response{{"request_id"s, route_req_data.at("id"s).AsInt()},
+                                      {"error_message"s, "not found"s}};
+                        if (!explanation.router.empty())
+                            response.insert({"explain"s, detail::RouteExplanationToDict(explanation)});
 
-                    string_view start_stop = route_req_data.at("from").AsString();
-                    string_view end_stop = route_req_data.at("to").AsString();
-                    auto ans = req_handler_.GetShortWayBetween(start_stop, end_stop);
+                        responses_array.push_back(move(response));
+                    }
+                }
+                else if (type == "Reachable"s)
+                {
+                    const auto &reachable_req_data = node.AsDict();
 
-                    if (ans.has_value())
+                    string_view start_stop = reachable_req_data.at("from"s).AsString();
+                    const double max_time = reachable_req_data.at("max_time"s).AsDouble();
+
+                    if (req_handler_.GetReachableStops(start_stop, max_time, reachable_stops))
                     {
-                        Array items((*ans).items.size());
-                        transform((*ans).items.begin(), (*ans).items.end(), items.begin(),
-                                  [](const PathDataItem &data)
-                                  {
-                                      Dict dict;
-                                      switch (data.index())
-                                      {
-                                      case 0:
-                                      {
-                                          const PathDataItemBus &info = get<PathDataItemBus>(data);
-                                          dict.insert({"type"s, info.type});
-                                          dict.insert({"bus"s, string(info.name)});
-                                          dict.insert({"span_count"s, info.span_count});
-                                          dict.insert({"time"s, info.time});
-                                          break;
-                                      }
-                                      case 1:
-                                      {
-                                          const PathDataItemWait &info = get<PathDataItemWait>(data);
-                                          dict.insert({"type"s, info.type});
-                                          dict.insert({"stop_name"s, string(info.stop_name)});
-                                          dict.insert({"time"s, info.time});
-                                          break;
-                                      }
-                                      }
-                                      return dict;
-                                  });
+                        const auto &stops = db_.GetAllStops();
+                        Array items(reachable_stops.size());
+                        transform(reachable_stops.begin(), reachable_stops.end(), items.begin(),
+                                  [&stops](const ReachableStop &reachable_stop)
+                                  { return Dict{{"stop_name"s, stops[reachable_stop.stop_index].name},
+                                                {"time"s, reachable_stop.time}}; });
 
                         responses_array.push_back(
                             Builder{}
                                 .StartDict()
                                 .Key("request_id"s)
-                                .Value(route_req_data.at("id"s).AsInt())
-                                .Key("total_time"s)
-                                .Value((*ans).total_time)
+                                .Value(reachable_req_data.at("id"s).AsInt())
                                 .Key("items"s)
                                 .Value(move(items))
                                 .EndDict()
@@ -308,13 +344,63 @@ namespace transport_catalogue
                             Builder{}
                                 .StartDict()
                                 .Key("request_id"s)
-                                .Value(route_req_data.at("id"s).AsInt())
+                                .Value(reachable_req_data.at("id"s).AsInt())
                                 .Key("error_message"s)
                                 .Value("not found"s)
                                 .EndDict()
                                 .Build());
                     }
                 }
+                else if (type == "RouteMatrix"s)
+                {
+                    const auto &matrix_req_data = node.AsDict();
+
+                    vector<string_view> start_stops;
+                    for (const auto &stop_node : matrix_req_data.at("from"s).AsArray())
+                        start_stops.push_back(stop_node.AsString());
+
+                    vector<string_view> end_stops;
+                    for (const auto &stop_node : matrix_req_data.at("to"s).AsArray())
+                        end_stops.push_back(stop_node.AsString());
+
+                    const bool with_items = matrix_req_data.count("items"s) != 0 && matrix_req_data.at("items"s).AsBool();
+                    auto matrix = req_handler_.GetRouteMatrix(start_stops, end_stops, with_items);
+
+                    // Недостижимые пары и неизвестные остановки дают null в соответствующей ячейке
+                    Array total_times(matrix.from_count);
+                    Array items(with_items ? matrix.from_count : 0);
+                    for (size_t row = 0; row < matrix.from_count; ++row)
+                    {
+                        Array total_times_row(matrix.to_count);
+                        Array items_row(with_items ? matrix.to_count : 0);
+                        for (size_t column = 0; column < matrix.to_count; ++column)
+                        {
+                            const size_t cell = row * matrix.to_count + column;
+                            if (!matrix.total_times[cell])
+                                continue;
+
+                            total_times_row[column] = *matrix.total_times[cell];
+                            if (with_items)
+                            {
+                                Array cell_items(matrix.items[cell].size());
+                                transform(matrix.items[cell].begin(), matrix.items[cell].end(), cell_items.begin(),
+                                          [this](const RouteItem &item)
+                                          { return detail::RouteItemToDict(item, db_); });
+                                items_row[column] = move(cell_items);
+                            }
+                        }
+                        total_times[row] = move(total_times_row);
+                        if (with_items)
+                            items[row] = move(items_row);
+                    }
+
+                    Dict response{{"request_id"s, matrix_req_data.at("id"s).AsInt()},
+                                  {"total_times"s, move(total_times)}};
+                    if (with_items)
+                        response.insert({"items"s, move(items)});
+
+                    responses_array.push_back(move(response));
+                }
             }
 
             Print(Document{Node{responses_array}}, out);
@@ -323,6 +409,80 @@ namespace transport_catalogue
     } // namespace iodata
 
     namespace detail {
+        json::Dict RouteItemToDict(const RouteItem &item, const TransportCatalogue &db)
+        {
+            json::Dict dict;
+            switch (item.kind)
+            {
+            case RouteItemKind::BUS:
+                dict.insert({"type"s, "Bus"s});
+                dict.insert({"bus"s, db.GetAllBuses()[item.id].name});
+                dict.insert({"span_count"s, static_cast<int>(item.span_count)});
+                dict.insert({"time"s, item.time});
+                break;
+            case RouteItemKind::WAIT:
+                dict.insert({"type"s, "Wait"s});
+                dict.insert({"stop_name"s, db.GetAllStops()[item.id].name});
+                dict.insert({"time"s, item.time});
+                break;
+            case RouteItemKind::WALK:
+                // stop_name - остановка посадки или высадки, у пешего маршрута без автобусов её нет
+                dict.insert({"type"s, "Walk"s});
+                if (item.id != NO_STOP_INDEX)
+                    dict.insert({"stop_name"s, db.GetAllStops()[item.id].name});
+                dict.insert({"time"s, item.time});
+                break;
+            }
+            return dict;
+        }
+
+        json::Dict RouteExplanationToDict(const router::RouteExplanation &explanation)
+        {
+            const graph::SearchStats &stats = explanation.stats;
+            return json::Dict{{"router"s, string(explanation.router)},
+                              {"settled_vertices"s, static_cast<int>(stats.settled_vertices)},
+                              {"relaxed_edges"s, static_cast<int>(stats.relaxed_edges)},
+                              {"heap_pushes"s, static_cast<int>(stats.heap_pushes)},
+                              {"heap_pops"s, static_cast<int>(stats.heap_pops)},
+                              {"cache_hits"s, static_cast<int>(stats.cache_hits)},
+                              {"cache_misses"s, static_cast<int>(stats.cache_misses)},
+                              {"search_time_ms"s, explanation.search_ms},
+                              {"unpack_time_ms"s, explanation.unpack_ms}};
+        }
+
+        geo::Coordinates ParseCoordinates(const json::Node &node)
+        {
+            const json::Dict &point = node.AsDict();
+            return {point.at("latitude"s).AsDouble(), point.at("longitude"s).AsDouble()};
+        }
+
+        RequestHandler::RoutePoint ParseRoutePoint(const json::Node &node)
+        {
+            if (node.IsDict())
+                return ParseCoordinates(node);
+            return string_view(node.AsString());
+        }
+
+        router::RoutingSettings ParseRoutingSettings(const json::Dict &routing_settings)
+        {
+            router::RoutingSettings rs;
+            rs.bus_wait_time = routing_settings.at("bus_wait_time"s).AsDouble();
+            rs.bus_velocity = routing_settings.at("bus_velocity"s).AsDouble();
+            if (routing_settings.count("router"s) != 0)
+                rs.router_type = router::ParseRouterType(routing_settings.at("router"s).AsString());
+            if (routing_settings.count("tree_cache_memory_mb"s) != 0)
+                rs.tree_cache_memory_mb = routing_settings.at("tree_cache_memory_mb"s).AsInt();
+            if (routing_settings.count("landmark_count"s) != 0)
+                rs.landmark_count = routing_settings.at("landmark_count"s).AsInt();
+            if (routing_settings.count("vertex_order"s) != 0)
+                rs.vertex_order = router::ParseVertexOrder(routing_settings.at("vertex_order"s).AsString());
+            if (routing_settings.count("walk_velocity"s) != 0)
+                rs.walk_velocity = routing_settings.at("walk_velocity"s).AsDouble();
+            if (routing_settings.count("nearest_stop_count"s) != 0)
+                rs.nearest_stop_count = routing_settings.at("nearest_stop_count"s).AsInt();
+            return rs;
+        }
+
         svg::Color ParseColor(const json::Node &node)
         {
             if (node.IsString())
@@ -19,6 +19,14 @@ namespace transport_catalogue
 {
     namespace detail {
         svg::Color ParseColor(const json::Node &node);
+        // Словарь routing_settings; отсутствующие необязательные ключи оставляют значения по умолчанию
+        router::RoutingSettings ParseRoutingSettings(const json::Dict &routing_settings);
+        json::Dict RouteItemToDict(const RouteItem &item, const TransportCatalogue &db);
+        json::Dict RouteExplanationToDict(const router::RouteExplanation &explanation);
+        // Точка {"latitude", "longitude"} в запросе Route
+        geo::Coordinates ParseCoordinates(const json::Node &node);
+        // Конец маршрута в запросе Route: точка или название остановки
+        RequestHandler::RoutePoint ParseRoutePoint(const json::Node &node);
     } // detail
 
     namespace iodata
@@ -1,3 +1,4 @@
+#include <exception>
 #include <fstream>
 #include <iostream>
 #include <string_view>
@@ -31,13 +32,18 @@ int main(int argc, char* argv[]) {
 
     const std::string_view mode(argv[1]);
 
-    serialization::Serialization serializator(db, rh);
-    if (mode == "make_base"sv) {
-        serializator.MakeBase(input_file);
-    } else if (mode == "process_requests"sv) {
-        serializator.ProcessRequests(input_file, output_file);
-    } else {
-        PrintUsage();
+    serialization::Serialization serializator(db, rh, tr);
+    try {
+        if (mode == "make_base"sv) {
+            serializator.MakeBase(input_file);
+        } else if (mode == "process_requests"sv) {
+            serializator.ProcessRequests(input_file, output_file);
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        cerr << "Error: "sv << e.what() << endl;
         return 1;
     }
 }
\ No newline at end of file
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GRAPH_MIN_PLUS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace graph::min_plus {
+
+// Шаг min-plus для строки плоской таблицы маршрутов: для каждого j, если
+// weight_from + weights_through[j] < weights[j], вес заменяется кандидатом, а предыдущее
+// ребро берётся из строки промежуточной вершины (или prev_edge_from, если там его нет).
+// Недостижимые ячейки хранят +inf и не проходят сравнение. Векторные варианты выбираются
+// по возможностям процессора при первом вызове и дают побитно ту же таблицу, что и скалярный
+using RelaxRowFunction = void (*)(float weight_from, uint32_t prev_edge_from,
+                                  const float* weights_through, const uint32_t* prev_edges_through,
+                                  float* weights, uint32_t* prev_edges, size_t count);
+
+inline constexpr uint32_t NO_EDGE = UINT32_MAX;
+
+inline void RelaxRowScalar(float weight_from, uint32_t prev_edge_from,
+                           const float* weights_through, const uint32_t* prev_edges_through,
+                           float* weights, uint32_t* prev_edges, size_t count) {
+    for (size_t j = 0; j < count; ++j) {
+        const float candidate_weight = weight_from + weights_through[j];
+        if (candidate_weight < weights[j]) {
+            weights[j] = candidate_weight;
+            prev_edges[j] = prev_edges_through[j] != NO_EDGE ? prev_edges_through[j] : prev_edge_from;
+        }
+    }
+}
+
+#ifdef GRAPH_MIN_PLUS_X86
+
+__attribute__((target("sse4.1")))
+inline void RelaxRowSse41(float weight_from, uint32_t prev_edge_from,
+                          const float* weights_through, const uint32_t* prev_edges_through,
+                          float* weights, uint32_t* prev_edges, size_t count) {
+    const __m128 weight_from_lanes = _mm_set1_ps(weight_from);
+    const __m128i prev_edge_from_lanes = _mm_set1_epi32(static_cast<int>(prev_edge_from));
+    const __m128i no_edge_lanes = _mm_set1_epi32(-1);
+
+    size_t j = 0;
+    for (; j + 4 <= count; j += 4) {
+        const __m128 candidate = _mm_add_ps(weight_from_lanes, _mm_loadu_ps(weights_through + j));
+        const __m128 current = _mm_loadu_ps(weights + j);
+        const __m128 improved = _mm_cmplt_ps(candidate, current);
+        if (_mm_movemask_ps(improved) == 0) {
+            continue;
+        }
+        _mm_storeu_ps(weights + j, _mm_blendv_ps(current, candidate, improved));
+
+        const __m128i prev_through = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev_edges_through + j));
+        const __m128i prev_current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev_edges + j));
+        const __m128i prev_candidate = _mm_blendv_epi8(prev_through, prev_edge_from_lanes,
+                                                       _mm_cmpeq_epi32(prev_through, no_edge_lanes));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(prev_edges + j),
+                         _mm_blendv_epi8(prev_current, prev_candidate, _mm_castps_si128(improved)));
+    }
+    RelaxRowScalar(weight_from, prev_edge_from, weights_through + j, prev_edges_through + j,
+                   weights + j, prev_edges + j, count - j);
+}
+
+__attribute__((target("avx2")))
+inline void RelaxRowAvx2(float weight_from, uint32_t prev_edge_from,
+                         const float* weights_through, const uint32_t* prev_edges_through,
+                         float* weights, uint32_t* prev_edges, size_t count) {
+    const __m256 weight_from_lanes = _mm256_set1_ps(weight_from);
+    const __m256i prev_edge_from_lanes = _mm256_set1_epi32(static_cast<int>(prev_edge_from));
+    const __m256i no_edge_lanes = _mm256_set1_epi32(-1);
+
+    size_t j = 0;
+    for (; j + 8 <= count; j += 8) {
+        const __m256 candidate = _mm256_add_ps(weight_from_lanes, _mm256_loadu_ps(weights_through + j));
+        const __m256 current = _mm256_loadu_ps(weights + j);
+        const __m256 improved = _mm256_cmp_ps(candidate, current, _CMP_LT_OQ);
+        if (_mm256_movemask_ps(improved) == 0) {
+            continue;
+        }
+        _mm256_storeu_ps(weights + j, _mm256_blendv_ps(current, candidate, improved));
+
+        const __m256i prev_through = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev_edges_through + j));
+        const __m256i prev_current = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev_edges + j));
+        const __m256i prev_candidate = _mm256_blendv_epi8(prev_through, prev_edge_from_lanes,
+                                                          _mm256_cmpeq_epi32(prev_through, no_edge_lanes));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(prev_edges + j),
+                            _mm256_blendv_epi8(prev_current, prev_candidate, _mm256_castps_si256(improved)));
+    }
+    RelaxRowScalar(weight_from, prev_edge_from, weights_through + j, prev_edges_through + j,
+                   weights + j, prev_edges + j, count - j);
+}
+
+#endif
+
+inline RelaxRowFunction SelectRelaxRow() {
+#ifdef GRAPH_MIN_PLUS_X86
+    if (__builtin_cpu_supports("avx2")) {
+        return RelaxRowAvx2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return RelaxRowSse41;
+    }
+#endif
+    return RelaxRowScalar;
+}
+
+inline RelaxRowFunction GetRelaxRow() {
+    static const RelaxRowFunction relax_row = SelectRelaxRow();
+    return relax_row;
+}
+
+}  // namespace graph::min_plus
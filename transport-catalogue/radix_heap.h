@@ -0,0 +1,133 @@
+#pragma once
+
+#include "graph.h"
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace graph {
+
+// Целочисленный ключ с тем же порядком, что и у неотрицательного веса. У неотрицательного
+// числа с плавающей точкой порядок битового представления совпадает с порядком значений,
+// поэтому ключ точный и веса не приходится округлять до шага сетки
+template <typename Weight>
+uint64_t ToRadixKey(Weight weight) {
+    if constexpr (std::is_floating_point_v<Weight>) {
+        static_assert(sizeof(Weight) == sizeof(uint64_t) || sizeof(Weight) == sizeof(uint32_t));
+        // -0.0 отличается от 0.0 знаковым битом
+        if (weight == Weight{}) {
+            return 0;
+        }
+        if constexpr (sizeof(Weight) == sizeof(uint64_t)) {
+            uint64_t bits;
+            std::memcpy(&bits, &weight, sizeof(bits));
+            return bits;
+        } else {
+            uint32_t bits;
+            std::memcpy(&bits, &weight, sizeof(bits));
+            return bits;
+        }
+    } else {
+        return static_cast<uint64_t>(weight);
+    }
+}
+
+// Монотонная поразрядная куча для поиска Дейкстры: извлекаемые веса не убывают, и добавлять
+// можно только вес не меньше последнего извлечённого. Элемент лежит в корзине по номеру старшего
+// бита, которым его ключ отличается от ключа последнего извлечённого. Извлечение раскладывает
+// первую непустую корзину заново, и каждый элемент переходит в корзины с меньшими номерами,
+// поэтому операция в среднем стоит O(log C) без сравнений и перестановок двоичной кучи.
+// Для A* куча не подходит: сумма веса и оценки у соседей может оказаться меньше извлечённой
+template <typename Weight>
+class RadixHeap {
+public:
+    struct Item {
+        Weight weight;
+        VertexId vertex;
+    };
+
+    bool IsEmpty() const {
+        return size_ == 0;
+    }
+
+    void Push(Weight weight, VertexId vertex) {
+        const uint64_t key = ToRadixKey(weight);
+        assert(key >= last_key_);
+        buckets_[GetBucket(key)].push_back({weight, vertex});
+        ++size_;
+    }
+
+    // Элемент с наименьшим весом; при равных весах порядок не определён
+    const Item& Top() {
+        if (buckets_[0].empty()) {
+            Redistribute();
+        }
+        return buckets_[0].back();
+    }
+
+    Item Pop() {
+        const Item item = Top();
+        buckets_[0].pop_back();
+        --size_;
+        return item;
+    }
+
+    void Clear() {
+        for (auto& bucket : buckets_) {
+            bucket.clear();
+        }
+        last_key_ = 0;
+        size_ = 0;
+    }
+
+private:
+    static constexpr size_t BUCKET_COUNT = 65;
+
+    size_t GetBucket(uint64_t key) const {
+        return key == last_key_ ? 0 : GetHighestBit(key ^ last_key_) + 1;
+    }
+
+    // Номер старшего единичного бита ненулевого значения
+    static size_t GetHighestBit(uint64_t value) {
+#if defined(__GNUC__)
+        return 63 - static_cast<size_t>(__builtin_clzll(value));
+#else
+        size_t res = 0;
+        while (value >>= 1) {
+            ++res;
+        }
+        return res;
+#endif
+    }
+
+    void Redistribute() {
+        size_t bucket = 1;
+        while (buckets_[bucket].empty()) {
+            ++bucket;
+        }
+
+        uint64_t min_key = ToRadixKey(buckets_[bucket].front().weight);
+        for (const Item& item : buckets_[bucket]) {
+            const uint64_t key = ToRadixKey(item.weight);
+            if (key < min_key) {
+                min_key = key;
+            }
+        }
+
+        last_key_ = min_key;
+        for (const Item& item : buckets_[bucket]) {
+            buckets_[GetBucket(ToRadixKey(item.weight))].push_back(item);
+        }
+        buckets_[bucket].clear();
+    }
+
+    std::array<std::vector<Item>, BUCKET_COUNT> buckets_;
+    uint64_t last_key_ = 0;
+    size_t size_ = 0;
+};
+
+}  // namespace graph
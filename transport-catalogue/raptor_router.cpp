@@ -0,0 +1,288 @@
+#include "raptor_router.h"
+#include "router.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace transport_catalogue
+{
+    namespace router
+    {
+        RaptorRouter::RaptorRouter(const deque<Bus> &buses,
+                                   const DictStopsPairToDistances &distances_map,
+                                   double minutes_per_meter, double wait_time)
+            : minutes_per_meter_(minutes_per_meter), wait_time_(wait_time)
+        {
+            for (uint32_t bus_index = 0; bus_index < buses.size(); ++bus_index)
+            {
+                const Bus &bus = buses[bus_index];
+                AddRoute(bus_index, bus.route.begin(), bus.route.end(), distances_map);
+
+                if (!bus.is_roundtrip)
+                {
+                    AddRoute(bus_index, bus.route.rbegin(), bus.route.rend(), distances_map);
+                }
+            }
+
+            stop_routes_offsets_.assign(stops_.size() + 1, 0);
+            for (const RouteStop &route_stop : route_stops_)
+            {
+                ++stop_routes_offsets_[route_stop.stop_index + 1];
+            }
+            for (size_t i = 1; i < stop_routes_offsets_.size(); ++i)
+            {
+                stop_routes_offsets_[i] += stop_routes_offsets_[i - 1];
+            }
+
+            stop_routes_.resize(route_stops_.size());
+            vector<size_t> next_positions(stop_routes_offsets_.begin(), prev(stop_routes_offsets_.end()));
+            for (size_t route_index = 0; route_index < routes_.size(); ++route_index)
+            {
+                for (size_t position = routes_[route_index].first_position;
+                     position < routes_[route_index].end_position;
+                     ++position)
+                {
+                    stop_routes_[next_positions[route_stops_[position].stop_index]++] = {route_index, position};
+                }
+            }
+        }
+
+        size_t RaptorRouter::GetStopIndex(const Stop *stop)
+        {
+            const auto [it, inserted] = stop_to_index_.emplace(stop, stops_.size());
+            if (inserted)
+            {
+                stops_.push_back(stop);
+            }
+            return it->second;
+        }
+
+        void RaptorRouter::SetRoutingSettings(double minutes_per_meter, double wait_time)
+        {
+            minutes_per_meter_ = minutes_per_meter;
+            wait_time_ = wait_time;
+        }
+
+        double RaptorRouter::GetRideTime(const Leg &leg) const
+        {
+            // Время поездки считается по сумме перегонов так же, как при поиске
+            double ride_meters = 0;
+            for (size_t position = leg.board_position + 1; position <= leg.alight_position; ++position)
+            {
+                ride_meters += route_stops_[position].segment_meters;
+            }
+            return ride_meters * minutes_per_meter_;
+        }
+
+        void RaptorRouter::Search(size_t start, size_t target, SearchState &state, double max_time) const
+        {
+            const double infinity = numeric_limits<double>::infinity();
+            const size_t stop_count = stops_.size();
+
+            // best_times - лучшее время по всем раундам, previous_times - на конец предыдущего раунда
+            auto &best_times = state.best_times;
+            best_times.assign(stop_count, infinity);
+            state.rounds_legs.assign(1, vector<Leg>(stop_count));
+
+            vector<double> previous_times;
+            vector<size_t> marked_stops{start};
+            vector<size_t> route_first_positions(routes_.size(), NO_ROUTE);
+            vector<size_t> routes_to_scan;
+            vector<bool> is_marked(stop_count, false);
+            // Для explain: осевшие вершины - улучшенные метки остановок, рёбра - просмотренные остановки маршрутов
+            graph::SearchStats *const stats = graph::GetThreadSearchStats();
+
+            best_times[start] = 0;
+            while (!marked_stops.empty())
+            {
+                previous_times = best_times;
+
+                for (const size_t stop : marked_stops)
+                {
+                    for (size_t i = stop_routes_offsets_[stop]; i < stop_routes_offsets_[stop + 1]; ++i)
+                    {
+                        const auto [route_index, position] = stop_routes_[i];
+                        if (route_first_positions[route_index] == NO_ROUTE)
+                        {
+                            routes_to_scan.push_back(route_index);
+                            route_first_positions[route_index] = position;
+                        }
+                        else
+                        {
+                            route_first_positions[route_index] = min(route_first_positions[route_index], position);
+                        }
+                    }
+                }
+                marked_stops.clear();
+
+                auto &legs = state.rounds_legs.emplace_back(stop_count);
+                for (const size_t route_index : routes_to_scan)
+                {
+                    const Route &route = routes_[route_index];
+                    if (stats)
+                        stats->relaxed_edges += route.end_position - route_first_positions[route_index];
+                    size_t board_position = NO_ROUTE;
+                    double boarded_time = infinity;
+                    double ride_meters = 0;
+
+                    for (size_t position = route_first_positions[route_index]; position < route.end_position; ++position)
+                    {
+                        const size_t stop = route_stops_[position].stop_index;
+                        if (board_position != NO_ROUTE)
+                        {
+                            ride_meters += route_stops_[position].segment_meters;
+                            const double arrival_time = boarded_time + ride_meters * minutes_per_meter_;
+                            if (arrival_time < best_times[stop] && arrival_time <= max_time &&
+                                (target == NO_STOP || arrival_time < best_times[target]))
+                            {
+                                best_times[stop] = arrival_time;
+                                legs[stop] = {route_index, board_position, position};
+                                if (!is_marked[stop])
+                                {
+                                    is_marked[stop] = true;
+                                    marked_stops.push_back(stop);
+                                }
+                            }
+                        }
+
+                        // Пересаживаемся на этот же маршрут здесь, если так выходит раньше
+                        if (previous_times[stop] != infinity)
+                        {
+                            const double candidate_time = previous_times[stop] + wait_time_;
+                            if (board_position == NO_ROUTE || candidate_time < boarded_time + ride_meters * minutes_per_meter_)
+                            {
+                                board_position = position;
+                                boarded_time = candidate_time;
+                                ride_meters = 0;
+                            }
+                        }
+                    }
+                    route_first_positions[route_index] = NO_ROUTE;
+                }
+                routes_to_scan.clear();
+                if (stats)
+                    stats->settled_vertices += marked_stops.size();
+
+                for (const size_t stop : marked_stops)
+                {
+                    is_marked[stop] = false;
+                }
+            }
+        }
+
+        bool RaptorRouter::ExtractRoute(const SearchState &state, size_t start, size_t target, RouteResult &route) const
+        {
+            route.total_time = 0;
+            route.items.clear();
+            if (state.best_times[target] == numeric_limits<double>::infinity())
+                return false;
+
+            // Восстанавливаем поездки с конца: каждая посадка опирается на метку предыдущего раунда
+            vector<Leg> journey;
+            size_t round = state.rounds_legs.size() - 1;
+            for (size_t stop = target; stop != start;)
+            {
+                while (state.rounds_legs[round][stop].route_index == NO_ROUTE)
+                {
+                    --round;
+                }
+                const Leg &leg = state.rounds_legs[round][stop];
+                journey.push_back(leg);
+                stop = route_stops_[leg.board_position].stop_index;
+                --round;
+            }
+
+            for (auto it = journey.rbegin(); it != journey.rend(); ++it)
+            {
+                const double ride_time = GetRideTime(*it);
+                route.items.push_back({RouteItemKind::WAIT,
+                                       transport_catalogue::GetStopIndex(*stops_[route_stops_[it->board_position].stop_index]),
+                                       0, wait_time_});
+                route.items.push_back({RouteItemKind::BUS, routes_[it->route_index].bus_index,
+                                       static_cast<uint32_t>(it->alight_position - it->board_position),
+                                       ride_time});
+                route.total_time = route.total_time + wait_time_;
+                route.total_time = route.total_time + ride_time;
+            }
+
+            return true;
+        }
+
+        bool RaptorRouter::BuildRoute(const Stop *start_stop, const Stop *end_stop, RouteResult &route) const
+        {
+            if (start_stop == end_stop)
+            {
+                route.total_time = 0;
+                route.items.clear();
+                return true;
+            }
+
+            const auto it_start = stop_to_index_.find(start_stop);
+            const auto it_end = stop_to_index_.find(end_stop);
+            if (it_start == stop_to_index_.end() || it_end == stop_to_index_.end())
+                return false;
+
+            SearchState state;
+            Search(it_start->second, it_end->second, state);
+            graph::MarkSearchFinished(graph::GetThreadSearchStats());
+            return ExtractRoute(state, it_start->second, it_end->second, route);
+        }
+
+        void RaptorRouter::GetReachableStops(const Stop *start_stop, double max_time, vector<ReachableStop> &stops) const
+        {
+            stops.clear();
+            if (max_time < 0)
+                return;
+
+            const auto it_start = stop_to_index_.find(start_stop);
+            if (it_start == stop_to_index_.end())
+            {
+                stops.push_back({transport_catalogue::GetStopIndex(*start_stop), 0});
+                return;
+            }
+
+            SearchState state;
+            Search(it_start->second, NO_STOP, state, max_time);
+            for (size_t stop = 0; stop < stops_.size(); ++stop)
+            {
+                if (state.best_times[stop] != numeric_limits<double>::infinity())
+                    stops.push_back({transport_catalogue::GetStopIndex(*stops_[stop]), state.best_times[stop]});
+            }
+            sort(stops.begin(), stops.end(), [](const ReachableStop &lhs, const ReachableStop &rhs)
+                 { return lhs.time < rhs.time; });
+        }
+
+        vector<optional<RouteResult>> RaptorRouter::BuildRoutesFrom(const Stop *start_stop,
+                                                                    const vector<const Stop *> &end_stops) const
+        {
+            vector<optional<RouteResult>> res(end_stops.size());
+
+            const auto it_start = stop_to_index_.find(start_stop);
+            SearchState state;
+            if (it_start != stop_to_index_.end())
+            {
+                // Без цели поиск доходит до всех остановок, достижимых из начальной
+                Search(it_start->second, NO_STOP, state);
+            }
+
+            for (size_t i = 0; i < end_stops.size(); ++i)
+            {
+                if (end_stops[i] == start_stop)
+                {
+                    res[i] = RouteResult{};
+                    continue;
+                }
+                const auto it_end = stop_to_index_.find(end_stops[i]);
+                RouteResult route;
+                if (it_start != stop_to_index_.end() && it_end != stop_to_index_.end() &&
+                    ExtractRoute(state, it_start->second, it_end->second, route))
+                {
+                    res[i] = move(route);
+                }
+            }
+            return res;
+        }
+    } // namespace router
+
+} // namespace transport_catalogue
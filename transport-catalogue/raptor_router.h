@@ -0,0 +1,124 @@
+#pragma once
+
+#include <deque>
+#include <limits>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "domain.h"
+#include "transport_catalogue.h"
+
+namespace transport_catalogue
+{
+    namespace router
+    {
+        // Поиск маршрутов по раундам в духе RAPTOR: вместо ребра на каждую пару остановок
+        // автобуса хранятся только последовательности остановок маршрутов и время перегонов.
+        // Раунд k находит лучшие времена прибытия не более чем с k посадками, каждый маршрут
+        // просматривается за один проход по его остановкам. Память и время построения
+        // линейны по суммарной длине маршрутов
+        class RaptorRouter
+        {
+        public:
+            RaptorRouter(const std::deque<Bus> &buses,
+                         const DictStopsPairToDistances &distances_map,
+                         double minutes_per_meter, double wait_time);
+
+            bool BuildRoute(const Stop *start_stop, const Stop *end_stop, RouteResult &route) const;
+            // Остановки, достижимые не дольше чем за max_time; поиск не продолжает метки сверх бюджета
+            void GetReachableStops(const Stop *start_stop, double max_time, std::vector<ReachableStop> &stops) const;
+            // Перегоны хранятся в метрах, поэтому смена скорости и времени ожидания не требует перестройки
+            void SetRoutingSettings(double minutes_per_meter, double wait_time);
+
+            // Маршруты из одной остановки во все end_stops за один поиск
+            std::vector<std::optional<RouteResult>> BuildRoutesFrom(const Stop *start_stop,
+                                                                    const std::vector<const Stop *> &end_stops) const;
+
+        private:
+            static constexpr size_t NO_ROUTE = std::numeric_limits<size_t>::max();
+            static constexpr size_t NO_STOP = std::numeric_limits<size_t>::max();
+
+            struct RouteStop
+            {
+                size_t stop_index;
+                // Дорожное расстояние от предыдущей остановки маршрута в метрах
+                double segment_meters;
+            };
+
+            struct Route
+            {
+                uint32_t bus_index;
+                size_t first_position;
+                size_t end_position;
+            };
+
+            struct StopRoute
+            {
+                size_t route_index;
+                size_t position;
+            };
+
+            struct Leg
+            {
+                size_t route_index = NO_ROUTE;
+                size_t board_position;
+                size_t alight_position;
+            };
+
+            struct SearchState
+            {
+                std::vector<double> best_times;
+                std::vector<std::vector<Leg>> rounds_legs;
+            };
+
+            template <typename It>
+            void AddRoute(uint32_t bus_index, It b_stops, It e_stops,
+                          const DictStopsPairToDistances &distances_map);
+
+            size_t GetStopIndex(const Stop *stop);
+            double GetRideTime(const Leg &leg) const;
+
+            // Раунды RAPTOR из start; при target != NO_STOP метки не хуже лучшего времени до цели отсекаются,
+            // метки позже max_time не ставятся
+            void Search(size_t start, size_t target, SearchState &state,
+                        double max_time = std::numeric_limits<double>::infinity()) const;
+            bool ExtractRoute(const SearchState &state, size_t start, size_t target, RouteResult &route) const;
+
+            double minutes_per_meter_;
+            double wait_time_;
+            std::vector<const Stop *> stops_;
+            std::unordered_map<const Stop *, size_t> stop_to_index_;
+
+            std::vector<Route> routes_;
+            std::vector<RouteStop> route_stops_;
+
+            // Маршруты, проходящие через остановку: stop_routes_[stop_routes_offsets_[i]..stop_routes_offsets_[i + 1])
+            std::vector<size_t> stop_routes_offsets_;
+            std::vector<StopRoute> stop_routes_;
+        };
+
+        template <typename It>
+        void RaptorRouter::AddRoute(uint32_t bus_index, It b_stops, It e_stops,
+                                    const DictStopsPairToDistances &distances_map)
+        {
+            Route route{bus_index, route_stops_.size(), route_stops_.size()};
+            for (auto it_stop = b_stops; it_stop != e_stops; ++it_stop)
+            {
+                double segment_meters = 0;
+                if (it_stop != b_stops)
+                {
+                    Stop *prev_stop = *prev(it_stop);
+                    if (distances_map.count({prev_stop, *it_stop}) > 0)
+                        segment_meters = distances_map.at({prev_stop, *it_stop});
+                    else if (distances_map.count({*it_stop, prev_stop}) > 0)
+                        segment_meters = distances_map.at({*it_stop, prev_stop});
+                }
+                route_stops_.push_back({GetStopIndex(*it_stop), segment_meters});
+            }
+            route.end_position = route_stops_.size();
+            routes_.push_back(route);
+        }
+    } // namespace router
+
+} // namespace transport_catalogue
@@ -58,7 +58,34 @@ namespace transport_catalogue
         return map_renderer_.RenderMap(buses);
     }
 
-    optional<PathData> RequestHandler::GetShortWayBetween(std::string_view start_stop, std::string_view end_stop)
+    bool RequestHandler::GetShortWayBetween(std::string_view start_stop, std::string_view end_stop, RouteResult &route)
+    {
+        Stop *start_stop_ptr = db_.FindStop(start_stop);
+        Stop *end_stop_ptr = db_.FindStop(end_stop);
+
+        if (!start_stop_ptr || !end_stop_ptr)
+            return false;
+
+        BuildRouter();
+
+        return transport_router_.BuildRoute(start_stop_ptr, end_stop_ptr, route);
+    }
+
+    bool RequestHandler::ExplainShortWayBetween(string_view start_stop, string_view end_stop, RouteResult &route,
+                                                RouteExplanation &explanation)
+    {
+        Stop *start_stop_ptr = db_.FindStop(start_stop);
+        Stop *end_stop_ptr = db_.FindStop(end_stop);
+
+        if (!start_stop_ptr || !end_stop_ptr)
+            return false;
+
+        BuildRouter();
+
+        return transport_router_.ExplainRoute(start_stop_ptr, end_stop_ptr, route, explanation);
+    }
+
+    optional<double> RequestHandler::GetRouteTime(string_view start_stop, string_view end_stop)
     {
         Stop *start_stop_ptr = db_.FindStop(start_stop);
         Stop *end_stop_ptr = db_.FindStop(end_stop);
@@ -66,17 +93,113 @@ namespace transport_catalogue
         if (!start_stop_ptr || !end_stop_ptr)
             return nullopt;
 
-        if (transport_router_.GetVertexAmount() == 0)
+        BuildRouter();
+
+        return transport_router_.GetRouteTime(start_stop_ptr, end_stop_ptr);
+    }
+
+    const StopLocator &RequestHandler::GetStopLocator()
+    {
+        if (!stop_locator_)
         {
-            transport_router_.SetVertexAmount(db_.GetAllStops().size() * 2);
-            transport_router_.FillDataToGraph(db_.GetAllBuses(), db_.GetDistancesMap());
+            const auto &all_stops = db_.GetAllStops();
+            vector<bool> added(all_stops.size(), false);
+            vector<const Stop *> stops;
+            for (const Bus &bus : db_.GetAllBuses())
+            {
+                for (const Stop *stop : bus.route)
+                {
+                    if (!added[GetStopIndex(*stop)])
+                    {
+                        added[GetStopIndex(*stop)] = true;
+                        stops.push_back(stop);
+                    }
+                }
+            }
+            stop_locator_ = make_unique<StopLocator>(move(stops));
         }
+        return *stop_locator_;
+    }
+
+    bool RequestHandler::GetRouteBetweenPoints(const RoutePoint &from, const RoutePoint &to, RouteResult &route,
+                                               RouteExplanation *explanation)
+    {
+        const size_t count = transport_router_.GetNearestStopCount();
+        // Точка получает ближайшие остановки, названная остановка - саму себя на нулевом расстоянии
+        const auto resolve = [&](const RoutePoint &point, geo::Coordinates &coordinates,
+                                 vector<NearestStop> &stops)
+        {
+            if (const auto *stop_name = get_if<string_view>(&point))
+            {
+                const Stop *stop = db_.FindStop(*stop_name);
+                if (!stop)
+                    return false;
+                coordinates = stop->coord;
+                stops = {NearestStop{stop, 0}};
+                return true;
+            }
+            coordinates = get<geo::Coordinates>(point);
+            stops = GetStopLocator().FindNearest(coordinates, count);
+            return true;
+        };
+
+        geo::Coordinates from_coordinates;
+        geo::Coordinates to_coordinates;
+        vector<NearestStop> from_stops;
+        vector<NearestStop> to_stops;
+        if (!resolve(from, from_coordinates, from_stops) || !resolve(to, to_coordinates, to_stops))
+            return false;
+
+        BuildRouter();
+
+        if (explanation)
+            transport_router_.ExplainRoute(from_coordinates, from_stops, to_coordinates, to_stops, route,
+                                           *explanation);
+        else
+            transport_router_.BuildRoute(from_coordinates, from_stops, to_coordinates, to_stops, route);
+        return true;
+    }
+
+    bool RequestHandler::GetReachableStops(string_view start_stop, double max_time, vector<ReachableStop> &stops)
+    {
+        Stop *start_stop_ptr = db_.FindStop(start_stop);
+        if (!start_stop_ptr)
+            return false;
+
+        BuildRouter();
+
+        transport_router_.GetReachableStops(start_stop_ptr, max_time, stops);
+        return true;
+    }
 
-        return transport_router_.GetShortWayBetween(start_stop_ptr, end_stop_ptr);
+    RouteMatrixData RequestHandler::GetRouteMatrix(const vector<string_view> &start_stops,
+                                                   const vector<string_view> &end_stops,
+                                                   bool with_items)
+    {
+        vector<const Stop *> start_stops_ptr(start_stops.size());
+        transform(start_stops.begin(), start_stops.end(), start_stops_ptr.begin(), [&](string_view stop_name)
+                  { return db_.FindStop(stop_name); });
+
+        vector<const Stop *> end_stops_ptr(end_stops.size());
+        transform(end_stops.begin(), end_stops.end(), end_stops_ptr.begin(), [&](string_view stop_name)
+                  { return db_.FindStop(stop_name); });
+
+        BuildRouter();
+
+        return transport_router_.GetRouteMatrix(start_stops_ptr, end_stops_ptr, with_items);
     }
 
     void RequestHandler::SetRoutingSettings(RoutingSettings &settings)
     {
         transport_router_.SetOrUpdateRoutingSettings(settings);
     }
+
+    void RequestHandler::BuildRouter()
+    {
+        if (transport_router_.GetVertexAmount() == 0)
+        {
+            transport_router_.SetVertexAmount(db_.GetAllStops().size() * 2);
+            transport_router_.FillDataToGraph(db_.GetAllBuses(), db_.GetDistancesMap());
+        }
+    }
 } // namespace transport_catalogue
@@ -10,6 +10,8 @@
 #include <vector>
 #include <algorithm>
 #include <optional>
+#include <memory>
+#include <variant>
 
 // Класс RequestHandler играет роль Фасада, упрощающего взаимодействие JSON reader-а
 // с другими подсистемами приложения.
@@ -30,15 +32,43 @@ namespace transport_catalogue
         const std::unordered_set<std::string_view> *GetBusesByStop(const std::string_view &stop_name) const;
 
         svg::Document RenderMap() const;
-        std::optional<PathData> GetShortWayBetween(std::string_view start_stop, std::string_view end_stop);
+        // Заполняет route кратчайшим маршрутом (запрос Route), false - маршрут не найден
+        bool GetShortWayBetween(std::string_view start_stop, std::string_view end_stop, RouteResult &route);
+        // GetShortWayBetween с разбором поиска (запрос Route с "explain": true)
+        bool ExplainShortWayBetween(std::string_view start_stop, std::string_view end_stop, RouteResult &route,
+                                    router::RouteExplanation &explanation);
+        // Время в пути без элементов маршрута (запрос Route с "items": false)
+        std::optional<double> GetRouteTime(std::string_view start_stop, std::string_view end_stop);
+        // Конец маршрута в запросе Route: название остановки или точка
+        using RoutePoint = std::variant<std::string_view, geo::Coordinates>;
+        // Маршрут с пешими участками до ближайших к точкам остановок (запрос Route с координатами
+        // в from или to). Названная остановка служит единственной остановкой своего конца без пешего
+        // участка. Пеший маршрут есть всегда, false - названной остановки нет. Если explanation
+        // передан, в него записывается разбор поиска
+        bool GetRouteBetweenPoints(const RoutePoint &from, const RoutePoint &to, RouteResult &route,
+                                   router::RouteExplanation *explanation = nullptr);
+        // Остановки, достижимые из start_stop не дольше чем за max_time минут (запрос Reachable),
+        // false - остановка не найдена
+        bool GetReachableStops(std::string_view start_stop, double max_time, std::vector<ReachableStop> &stops);
+        // Матрица времени в пути между всеми парами остановок из списков (запрос RouteMatrix)
+        RouteMatrixData GetRouteMatrix(const std::vector<std::string_view> &start_stops,
+                                       const std::vector<std::string_view> &end_stops,
+                                       bool with_items);
 
         void SetRenderSettings(renderer::RenderSettings &settings);
         void SetRoutingSettings(router::RoutingSettings &settings);
 
+        // Строит граф маршрутов по данным справочника, если он ещё не построен или не загружен
+        void BuildRouter();
+
     private:
         // RequestHandler использует агрегацию объектов "Транспортный Справочник" и "Визуализатор Карты"
         const TransportCatalogue &db_;
         renderer::MapRenderer &map_renderer_;
         router::TransportRouter &transport_router_;
+        // Индекс остановок, через которые проходят автобусы; строится по первому запросу с координатами
+        std::unique_ptr<StopLocator> stop_locator_;
+
+        const StopLocator &GetStopLocator();
     };
 } // namespace transport_catalogue
@@ -1,41 +1,302 @@
 #pragma once
 
 #include "graph.h"
+#include "radix_heap.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <exception>
+#include <functional>
 #include <iterator>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 namespace graph {
 
-template <typename Weight>
-class Router {
+// Счётчики одного запроса маршрута для разбора медленных запросов (explain). Маршрутизаторы
+// заполняют их, только если текущий поток включил сбор через SearchStatsScope, иначе поиск
+// лишь проверяет указатель, прочитанный один раз в начале
+struct SearchStats {
+    size_t settled_vertices = 0;
+    size_t relaxed_edges = 0;
+    size_t heap_pushes = 0;
+    size_t heap_pops = 0;
+    size_t cache_hits = 0;
+    size_t cache_misses = 0;
+    // Момент, когда вес маршрута найден и начинается восстановление пути
+    std::optional<std::chrono::steady_clock::time_point> search_finished;
+};
+
+// Счётчики, включённые в текущем потоке, или nullptr
+inline SearchStats*& GetThreadSearchStats() {
+    thread_local SearchStats* stats = nullptr;
+    return stats;
+}
+
+// Включает сбор счётчиков в stats на время жизни объекта
+class SearchStatsScope {
+public:
+    explicit SearchStatsScope(SearchStats& stats)
+        : previous_(GetThreadSearchStats())
+    {
+        GetThreadSearchStats() = &stats;
+    }
+    SearchStatsScope(const SearchStatsScope&) = delete;
+    SearchStatsScope& operator=(const SearchStatsScope&) = delete;
+    ~SearchStatsScope() {
+        GetThreadSearchStats() = previous_;
+    }
+
 private:
-    using Graph = DirectedWeightedGraph<Weight>;
+    SearchStats* previous_;
+};
+
+// Отмечает конец поиска; повторные отметки (например, запасной поиск) не сдвигают первую
+inline void MarkSearchFinished(SearchStats* stats) {
+    if (stats && !stats->search_finished) {
+        stats->search_finished = std::chrono::steady_clock::now();
+    }
+}
 
+// Запускает func(thread_index, failed) в thread_count потоках, включая текущий, и дожидается всех.
+// Первое исключение из любого потока (или ошибка создания потока) выставляет failed, вызывает
+// on_failure и пробрасывается после join; func сама прекращает работу, увидев failed
+template <typename Func, typename OnFailure>
+void RunInThreads(size_t thread_count, Func func, OnFailure on_failure) {
+    std::atomic<bool> failed{false};
+    std::exception_ptr first_exception;
+    std::mutex exception_mutex;
+    const auto fail = [&](std::exception_ptr exception) {
+        {
+            std::lock_guard guard(exception_mutex);
+            if (!first_exception) {
+                first_exception = exception;
+            }
+        }
+        failed = true;
+        on_failure();
+    };
+    const auto worker = [&](size_t thread_index) {
+        try {
+            func(thread_index, failed);
+        } catch (...) {
+            fail(std::current_exception());
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count > 0 ? thread_count - 1 : 0);
+    try {
+        for (size_t i = 1; i < thread_count; ++i) {
+            threads.emplace_back(worker, i);
+        }
+    } catch (...) {
+        // Не удалось создать поток: уже запущенные увидят failed и будут присоединены ниже
+        fail(std::current_exception());
+    }
+    worker(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (first_exception) {
+        std::rethrow_exception(first_exception);
+    }
+}
+
+// Вызывает func(index) для index из [0, count) в thread_count потоках, включая текущий.
+// Потоки разбирают индексы по одному, поэтому неравные по стоимости задачи распределяются сами.
+// После исключения новые индексы не выдаются, все потоки присоединяются, а первое исключение
+// пробрасывается вызывающему
+template <typename Func>
+void ParallelFor(size_t count, size_t thread_count, Func func) {
+    thread_count = std::min(thread_count, count);
+    if (thread_count <= 1) {
+        for (size_t index = 0; index < count; ++index) {
+            func(index);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next_index{0};
+    RunInThreads(thread_count, [&](size_t, const std::atomic<bool>& failed) {
+        for (size_t index = next_index++; index < count && !failed; index = next_index++) {
+            func(index);
+        }
+    }, [] {});
+}
+
+// Многоразовый барьер для фиксированного числа потоков (std::barrier появился только в C++20).
+// Break отпускает всех ожидающих и делает последующие ожидания мгновенными - так сбой одного
+// потока не оставляет остальные ждать его навсегда
+class ThreadBarrier {
 public:
-    explicit Router(const Graph& graph);
+    explicit ThreadBarrier(size_t thread_count)
+        : thread_count_(thread_count) {
+    }
+
+    void ArriveAndWait() {
+        std::unique_lock lock(mutex_);
+        if (broken_) {
+            return;
+        }
+        const size_t generation = generation_;
+        if (++arrived_ == thread_count_) {
+            arrived_ = 0;
+            ++generation_;
+            condition_.notify_all();
+            return;
+        }
+        condition_.wait(lock, [&] {
+            return broken_ || generation_ != generation;
+        });
+    }
 
+    void Break() {
+        std::lock_guard guard(mutex_);
+        broken_ = true;
+        condition_.notify_all();
+    }
+
+private:
+    const size_t thread_count_;
+    size_t arrived_ = 0;
+    size_t generation_ = 0;
+    bool broken_ = false;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+};
+
+template <typename Weight>
+class RouterBase // interface
+{
+public:
     struct RouteInfo {
         Weight weight;
         std::vector<EdgeId> edges;
     };
 
-    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    // Конец маршрута с неотрицательной добавкой к весу, например временем подхода к вершине
+    struct Endpoint {
+        VertexId vertex;
+        Weight extra_weight;
+    };
+
+    // Лучший маршрут между наборами концов: вес с добавками обоих концов и индексы выбранных концов
+    struct BestRouteInfo {
+        Weight weight;
+        size_t source_index;
+        size_t target_index;
+    };
+
+    virtual ~RouterBase() = default;
+
+    virtual std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const = 0;
+
+    // Записывает рёбра маршрута в буфер вызывающего и возвращает вес. Маршрутизаторы с готовыми
+    // таблицами переопределяют метод и при достаточной ёмкости буфера не выделяют память
+    virtual std::optional<Weight> BuildRouteInto(VertexId from, VertexId to, std::vector<EdgeId>& edges) const {
+        auto route = BuildRoute(from, to);
+        if (!route) {
+            return std::nullopt;
+        }
+        edges.assign(route->edges.begin(), route->edges.end());
+        return route->weight;
+    }
+
+    // Только вес маршрута, без рёбер. Маршрутизаторы, которые знают вес без восстановления
+    // пути, переопределяют метод
+    virtual std::optional<Weight> GetRouteWeight(VertexId from, VertexId to) const {
+        auto route = BuildRoute(from, to);
+        if (!route) {
+            return std::nullopt;
+        }
+        return route->weight;
+    }
+
+    // Маршруты из одной вершины во все вершины targets. По умолчанию - отдельный
+    // BuildRoute на каждую пару; маршрутизаторы с поиском из источника переопределяют
+    // метод, чтобы обходиться одним поиском
+    virtual std::vector<std::optional<RouteInfo>> BuildRoutesFrom(VertexId from,
+                                                                  const std::vector<VertexId>& targets) const {
+        std::vector<std::optional<RouteInfo>> routes;
+        routes.reserve(targets.size());
+        for (const VertexId to : targets) {
+            routes.push_back(BuildRoute(from, to));
+        }
+        return routes;
+    }
 
+    // Лучший маршрут из любой вершины sources в любую вершину targets с учётом добавок концов,
+    // рёбра записываются в edges. По умолчанию вес каждой пары берётся из GetRouteWeight, а рёбра
+    // восстанавливаются только для лучшей пары. Так работают Router и CompactRouter (обращения
+    // к таблице), HubLabelRouter и ContractionHierarchyRouter (слияние меток и двунаправленный
+    // поиск на пару) и TreeCacheRouter (не больше одного дерева на источник, дальше ответы из кэша).
+    // DijkstraRouter и AStarRouter переопределяют метод одним поиском из всех источников сразу
+    virtual std::optional<BestRouteInfo> BuildBestRoute(const std::vector<Endpoint>& sources,
+                                                        const std::vector<Endpoint>& targets,
+                                                        std::vector<EdgeId>& edges) const {
+        std::optional<BestRouteInfo> best;
+        for (size_t source_index = 0; source_index < sources.size(); ++source_index) {
+            for (size_t target_index = 0; target_index < targets.size(); ++target_index) {
+                const auto weight = GetRouteWeight(sources[source_index].vertex, targets[target_index].vertex);
+                if (!weight) {
+                    continue;
+                }
+                const Weight total_weight =
+                    sources[source_index].extra_weight + *weight + targets[target_index].extra_weight;
+                if (!best || total_weight < best->weight) {
+                    best = BestRouteInfo{total_weight, source_index, target_index};
+                }
+            }
+        }
+        if (!best) {
+            return std::nullopt;
+        }
+        BuildRouteInto(sources[best->source_index].vertex, targets[best->target_index].vertex, edges);
+        return best;
+    }
+};
+
+template <typename Weight>
+class Router : public RouterBase<Weight> {
 private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
     struct RouteInternalData {
         Weight weight;
         std::optional<EdgeId> prev_edge;
     };
     using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
 
+    explicit Router(const Graph& graph);
+    // Блочный вариант предрасчёта: матрица обходится плитками BLOCK_SIZE x BLOCK_SIZE,
+    // независимые плитки каждой фазы распределяются между thread_count потоками
+    Router(const Graph& graph, size_t thread_count);
+    // Для разреженных графов: независимый Дейкстра из каждой вершины sources, источники
+    // распределяются между thread_count потоками. Строки остальных вершин остаются пустыми,
+    // маршруты из них не строятся
+    Router(const Graph& graph, const std::vector<VertexId>& sources, size_t thread_count);
+    Router(const Graph& graph, RoutesInternalData routes_internal_data);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    std::optional<Weight> BuildRouteInto(VertexId from, VertexId to, std::vector<EdgeId>& edges) const override;
+
+    const RoutesInternalData& GetRoutesInternalData() const;
+
+private:
+
     void InitializeRoutesInternalData(const Graph& graph) {
         const size_t vertex_count = graph.GetVertexCount();
         for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
@@ -75,6 +336,106 @@ private:
         }
     }
 
+    void RelaxBlock(size_t block_from, size_t block_to, size_t block_through) {
+        const size_t vertex_count = routes_internal_data_.size();
+        const size_t from_end = std::min(vertex_count, (block_from + 1) * BLOCK_SIZE);
+        const size_t to_end = std::min(vertex_count, (block_to + 1) * BLOCK_SIZE);
+        const size_t through_end = std::min(vertex_count, (block_through + 1) * BLOCK_SIZE);
+
+        for (VertexId vertex_through = block_through * BLOCK_SIZE; vertex_through < through_end; ++vertex_through) {
+            const auto& routes_through = routes_internal_data_[vertex_through];
+            for (VertexId vertex_from = block_from * BLOCK_SIZE; vertex_from < from_end; ++vertex_from) {
+                if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
+                    for (VertexId vertex_to = block_to * BLOCK_SIZE; vertex_to < to_end; ++vertex_to) {
+                        if (const auto& route_to = routes_through[vertex_to]) {
+                            RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    void FillRoutesFromSource(const CompressedGraph<Weight>& compressed_graph, VertexId from) {
+        // Строка таблицы сама служит массивом расстояний поиска, устаревшие элементы очереди пропускаются
+        auto& routes_from = routes_internal_data_[from];
+        RadixHeap<Weight> queue;
+        queue.Push(ZERO_WEIGHT, from);
+        routes_from[from] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+
+        while (!queue.IsEmpty()) {
+            const auto [weight, vertex] = queue.Pop();
+            if (routes_from[vertex]->weight < weight) {
+                continue;
+            }
+
+            const size_t edges_end = compressed_graph.GetFirstEdge(vertex + 1);
+            for (size_t position = compressed_graph.GetFirstEdge(vertex); position < edges_end; ++position) {
+                const VertexId target = compressed_graph.GetEdgeTarget(position);
+                const Weight candidate_weight = weight + compressed_graph.GetEdgeWeight(position);
+                auto& route_to = routes_from[target];
+                if (!route_to || candidate_weight < route_to->weight) {
+                    route_to = RouteInternalData{candidate_weight, compressed_graph.GetEdgeId(position)};
+                    queue.Push(candidate_weight, target);
+                }
+            }
+        }
+    }
+
+    void RelaxRoutesInternalDataBlocked(size_t thread_count) {
+        const size_t block_count = (routes_internal_data_.size() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        thread_count = std::max<size_t>(std::min(thread_count, block_count), 1);
+
+        // Один набор потоков на весь расчёт: фазы каждой ведущей плитки разделены барьером,
+        // задачи фазы распределяются между потоками по номеру потока. При сбое барьер
+        // разрушается, и остальные потоки выходят, не дожидаясь упавшего
+        ThreadBarrier barrier(thread_count);
+        RunInThreads(thread_count, [&](size_t thread_index, const std::atomic<bool>& failed) {
+            const auto run_phase = [&](size_t task_count, const auto& task) {
+                for (size_t index = thread_index; index < task_count && !failed; index += thread_count) {
+                    task(index);
+                }
+                barrier.ArriveAndWait();
+            };
+
+            for (size_t block_through = 0; block_through < block_count && !failed; ++block_through) {
+                // Фаза 1: диагональная плитка зависит только от себя
+                run_phase(1, [&](size_t) {
+                    RelaxBlock(block_through, block_through, block_through);
+                });
+
+                // Фаза 2: плитки той же строки и того же столбца зависят от диагональной
+                run_phase(2 * block_count, [&](size_t index) {
+                    const size_t block = index / 2;
+                    if (block == block_through) {
+                        return;
+                    }
+                    if (index % 2 == 0) {
+                        RelaxBlock(block_through, block, block_through);
+                    } else {
+                        RelaxBlock(block, block_through, block_through);
+                    }
+                });
+
+                // Фаза 3: остальные плитки зависят только от плиток фазы 2 и независимы между собой,
+                // поэтому строки плиток обрабатываются параллельно
+                run_phase(block_count, [&](size_t block_from) {
+                    if (block_from == block_through) {
+                        return;
+                    }
+                    for (size_t block_to = 0; block_to < block_count; ++block_to) {
+                        if (block_to != block_through) {
+                            RelaxBlock(block_from, block_to, block_through);
+                        }
+                    }
+                });
+            }
+        }, [&] {
+            barrier.Break();
+        });
+    }
+
+    static constexpr size_t BLOCK_SIZE = 64;
     static constexpr Weight ZERO_WEIGHT{};
     const Graph& graph_;
     RoutesInternalData routes_internal_data_;
@@ -95,14 +456,75 @@ Router<Weight>::Router(const Graph& graph)
 }
 
 template <typename Weight>
-std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
-                                                                             VertexId to) const {
+Router<Weight>::Router(const Graph& graph, size_t thread_count)
+    : graph_(graph)
+    , routes_internal_data_(graph.GetVertexCount(),
+                            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+{
+    InitializeRoutesInternalData(graph);
+    RelaxRoutesInternalDataBlocked(std::max<size_t>(thread_count, 1));
+}
+
+template <typename Weight>
+Router<Weight>::Router(const Graph& graph, const std::vector<VertexId>& sources, size_t thread_count)
+    : graph_(graph)
+    , routes_internal_data_(graph.GetVertexCount(),
+                            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+{
+    const size_t edge_count = graph.GetEdgeCount();
+    for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+    for (const VertexId from : sources) {
+        if (from >= graph.GetVertexCount()) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+    }
+
+    // Каждый поток пишет только в строки своих источников
+    const CompressedGraph<Weight> compressed_graph(graph);
+    ParallelFor(sources.size(), std::max<size_t>(thread_count, 1), [&](size_t index) {
+        FillRoutesFromSource(compressed_graph, sources[index]);
+    });
+}
+
+template <typename Weight>
+Router<Weight>::Router(const Graph& graph, RoutesInternalData routes_internal_data)
+    : graph_(graph)
+    , routes_internal_data_(std::move(routes_internal_data))
+{
+    const size_t vertex_count = graph.GetVertexCount();
+    if (routes_internal_data_.size() != vertex_count) {
+        throw std::invalid_argument("Routes data doesn't match the graph");
+    }
+    for (const auto& row : routes_internal_data_) {
+        if (row.size() != vertex_count) {
+            throw std::invalid_argument("Routes data doesn't match the graph");
+        }
+        for (const auto& route : row) {
+            if (route && route->prev_edge && *route->prev_edge >= graph.GetEdgeCount()) {
+                throw std::invalid_argument("Routes data doesn't match the graph");
+            }
+        }
+    }
+}
+
+template <typename Weight>
+const typename Router<Weight>::RoutesInternalData& Router<Weight>::GetRoutesInternalData() const {
+    return routes_internal_data_;
+}
+
+template <typename Weight>
+std::optional<Weight> Router<Weight>::BuildRouteInto(VertexId from, VertexId to,
+                                                     std::vector<EdgeId>& edges) const {
     const auto& route_internal_data = routes_internal_data_.at(from).at(to);
+    MarkSearchFinished(GetThreadSearchStats());
     if (!route_internal_data) {
         return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
-    std::vector<EdgeId> edges;
+    edges.clear();
     for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
          edge_id;
          edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
@@ -111,7 +533,18 @@ std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(Ver
     }
     std::reverse(edges.begin(), edges.end());
 
-    return RouteInfo{weight, std::move(edges)};
+    return route_internal_data->weight;
+}
+
+template <typename Weight>
+std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
+                                                                             VertexId to) const {
+    std::vector<EdgeId> edges;
+    const auto weight = BuildRouteInto(from, to, edges);
+    if (!weight) {
+        return std::nullopt;
+    }
+    return RouteInfo{*weight, std::move(edges)};
 }
 
 }  // namespace graph
\ No newline at end of file
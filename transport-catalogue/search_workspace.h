@@ -0,0 +1,112 @@
+#pragma once
+
+#include "graph.h"
+#include "radix_heap.h"
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace graph {
+
+// Рабочие массивы одного поиска по графу: вес, последнее ребро и отметки каждой вершины.
+// Массивы выделяются один раз и сбрасываются перед поиском за O(1) сменой поколения: данные
+// вершины действительны, только если её отметка равна текущему поколению. Поэтому поиск платит
+// лишь за вершины, до которых дошёл. Одно рабочее место не разделяется между потоками,
+// у каждого потока свои (GetThreadWorkspace)
+template <typename Weight>
+class SearchWorkspace {
+public:
+    static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+    // Элемент двоичной кучи: key - вес с нижней оценкой остатка пути (A*)
+    struct QueueItem {
+        Weight key;
+        Weight weight;
+        VertexId vertex;
+
+        bool operator>(const QueueItem& other) const {
+            return other.key < key;
+        }
+    };
+
+    // Начинает новый поиск по графу из vertex_count вершин
+    void Reset(size_t vertex_count);
+
+    bool IsReached(VertexId vertex) const {
+        return vertices_[vertex].reached_generation == generation_;
+    }
+    Weight GetWeight(VertexId vertex) const {
+        return vertices_[vertex].weight;
+    }
+    // Последнее ребро пути до достигнутой вершины, NO_EDGE у начальной
+    EdgeId GetPrevEdge(VertexId vertex) const {
+        return vertices_[vertex].prev_edge;
+    }
+    void Reach(VertexId vertex, Weight weight, EdgeId prev_edge) {
+        auto& state = vertices_[vertex];
+        state.weight = weight;
+        state.prev_edge = prev_edge;
+        state.reached_generation = generation_;
+    }
+
+    bool IsSettled(VertexId vertex) const {
+        return vertices_[vertex].settled_generation == generation_;
+    }
+    void Settle(VertexId vertex) {
+        vertices_[vertex].settled_generation = generation_;
+    }
+
+    bool IsTarget(VertexId vertex) const {
+        return vertices_[vertex].target_generation == generation_;
+    }
+    void MarkTarget(VertexId vertex) {
+        vertices_[vertex].target_generation = generation_;
+    }
+
+    // Очереди переиспользуют память между поисками. Поиск Дейкстры берёт поразрядную кучу,
+    // поиск с немонотонными ключами (A*) - двоичную кучу для std::push_heap/std::pop_heap с std::greater
+    RadixHeap<Weight> frontier;
+    std::vector<QueueItem> queue;
+
+private:
+    struct VertexState {
+        Weight weight;
+        EdgeId prev_edge;
+        uint32_t reached_generation;
+        uint32_t settled_generation;
+        uint32_t target_generation;
+    };
+
+    std::vector<VertexState> vertices_;
+    uint32_t generation_ = 0;
+};
+
+template <typename Weight>
+void SearchWorkspace<Weight>::Reset(size_t vertex_count) {
+    frontier.Clear();
+    queue.clear();
+    // Новые вершины получают нулевые отметки, а поколение всегда больше нуля
+    if (vertices_.size() < vertex_count) {
+        vertices_.resize(vertex_count, VertexState{Weight{}, NO_EDGE, 0, 0, 0});
+    }
+    if (++generation_ == 0) {
+        for (auto& state : vertices_) {
+            state.reached_generation = state.settled_generation = state.target_generation = 0;
+        }
+        generation_ = 1;
+    }
+}
+
+inline constexpr size_t THREAD_WORKSPACE_SLOTS = 2;
+
+// Рабочее место текущего потока. Поиск, которому нужны два рабочих места одновременно
+// (двунаправленный), берёт их с разными slot. Вложенные поиски с одним slot недопустимы
+template <typename Weight>
+SearchWorkspace<Weight>& GetThreadWorkspace(size_t slot = 0) {
+    thread_local std::array<SearchWorkspace<Weight>, THREAD_WORKSPACE_SLOTS> workspaces;
+    return workspaces.at(slot);
+}
+
+}  // namespace graph
@@ -4,10 +4,25 @@ using namespace std;
 using namespace transport_catalogue;
 using namespace serialization;
 
-Serialization::Serialization(TransportCatalogue &db, RequestHandler &req_handler) :
-    db_(db), req_handler_(req_handler) {}
+namespace {
+    // Предел размера сообщения protobuf
+    constexpr size_t MAX_DATABASE_BYTES = static_cast<size_t>(numeric_limits<int>::max());
+
+    size_t GetVarintSize(uint64_t value) {
+        size_t size = 1;
+        while (value >= 0x80) {
+            value >>= 7;
+            ++size;
+        }
+        return size;
+    }
+}
 
-void Serialization::MakeBase(std::istream &input) const {
+Serialization::Serialization(TransportCatalogue &db, RequestHandler &req_handler,
+                             router::TransportRouter &transport_router) :
+    db_(db), req_handler_(req_handler), transport_router_(transport_router) {}
+
+void Serialization::MakeBase(std::istream &input) {
     json::Document doc = json::Load(input);
     const auto& values = doc.GetRoot().AsDict();
 
@@ -32,17 +47,34 @@ void Serialization::MakeBase(std::istream &input) const {
 
     transport_catalogue_serialize::RoutingSettings routing_settings_pb;
     if (values.count("routing_settings"s) != 0 && !values.at("routing_settings"s).AsDict().empty()) {
-        const auto& routing_settings = values.at("routing_settings"s).AsDict();
-        SerializeRoutingSettings(routing_settings_pb, routing_settings);
+        SerializeRoutingSettings(routing_settings_pb,
+                                 detail::ParseRoutingSettings(values.at("routing_settings"s).AsDict()));
+
+        // Граф и таблицы маршрутизатора строятся по уже сериализованным данным,
+        // чтобы идентификаторы остановок совпадали с восстановленными при обработке запросов
+        DeserializeBaseData(tc_pb);
+        DeserializeRoutingSettings(routing_settings_pb);
+        req_handler_.BuildRouter();
     }
 
     transport_catalogue_serialize::DataBase db_pb;
     *db_pb.mutable_tc() = std::move(tc_pb);
     *db_pb.mutable_render_settings() = std::move(render_settings_pb);
     *db_pb.mutable_route_settings() = std::move(routing_settings_pb);
+    // RAPTOR не хранит состояние в базе и строится по маршрутам справочника при первом запросе
+    if (transport_router_.GetRouter() != nullptr) {
+        const size_t reserved_bytes = db_pb.ByteSizeLong();
+        SerializeRouter(*db_pb.mutable_router(), reserved_bytes);
+    }
+    if (db_pb.ByteSizeLong() > MAX_DATABASE_BYTES) {
+        throw length_error("The database takes "s + to_string(db_pb.ByteSizeLong()) +
+                           " bytes, more than the serialization limit of "s + to_string(MAX_DATABASE_BYTES));
+    }
 
     ofstream out(filename, ios::binary);
-    db_pb.SerializeToOstream(&out);
+    if (!db_pb.SerializeToOstream(&out)) {
+        throw runtime_error("Failed to write the database to "s + filename);
+    }
 }
 
 void Serialization::ProcessRequests(istream &input, ostream &out) {
@@ -54,7 +86,12 @@ void Serialization::ProcessRequests(istream &input, ostream &out) {
         string filename = values.at("serialization_settings"s).AsDict().at("file"s).AsString();
 
         ifstream inf(filename, ios::binary);
-        db_pb.ParseFromIstream(&inf);
+        if (!inf) {
+            throw runtime_error("Failed to open the database "s + filename);
+        }
+        if (!db_pb.ParseFromIstream(&inf)) {
+            throw runtime_error("The database "s + filename + " is corrupted"s);
+        }
     } else {
         throw std::logic_error("You have not specified a filename for serialization"s);
     }
@@ -62,6 +99,17 @@ void Serialization::ProcessRequests(istream &input, ostream &out) {
     DeserializeBaseData(db_pb.tc());
     DeserializeRenderSettings(db_pb.render_settings());
     DeserializeRoutingSettings(db_pb.route_settings());
+    if (db_pb.has_router()) {
+        DeserializeRouter(db_pb.router());
+    }
+
+    // Настройки маршрутизации в запросе заменяют сохранённые: веса загруженного графа пересчитываются на месте
+    if (values.count("routing_settings"s) != 0 && !values.at("routing_settings"s).AsDict().empty()) {
+        transport_catalogue_serialize::RoutingSettings routing_settings_pb;
+        SerializeRoutingSettings(routing_settings_pb,
+                                 detail::ParseRoutingSettings(values.at("routing_settings"s).AsDict()));
+        DeserializeRoutingSettings(routing_settings_pb);
+    }
 
     iodata::JsonReader json_reader(db_, req_handler_);
     json_reader.LoadFile(json::Document(values));
@@ -79,6 +127,11 @@ void Serialization::DeserializeBaseData(const transport_catalogue_serialize::Tra
 
     for (const auto &[stop_name, stops] : stop_to_stops_distances_queries)
     {
+        for (const auto &[other_stop_name, distance] : stops) {
+            if (!db_.FindStop(other_stop_name)) {
+                throw invalid_argument("Unknown stop in the database: "s + other_stop_name);
+            }
+        }
         vector<pair<string_view, double>> distances(stops.size());
 
         transform(stops.begin(), stops.end(), distances.begin(),
@@ -91,6 +144,11 @@ void Serialization::DeserializeBaseData(const transport_catalogue_serialize::Tra
     for (int i = 0; i < tc_pb.buses_size(); ++i)
     {
         const auto& bus_pb = tc_pb.buses(i);
+        for (const string &stop_name : bus_pb.route()) {
+            if (!db_.FindStop(stop_name)) {
+                throw invalid_argument("Unknown stop in the database: "s + stop_name);
+            }
+        }
 
         vector<string_view> stops(bus_pb.route_size());
 
@@ -144,10 +202,273 @@ void Serialization::DeserializeRoutingSettings(const transport_catalogue_seriali
 
     rs.bus_velocity = rs_pb.bus_velocity();
     rs.bus_wait_time = rs_pb.bus_wait_time();
+    rs.router_type = static_cast<router::RouterType>(rs_pb.router_type());
+    if (rs_pb.tree_cache_memory_mb() != 0) {
+        rs.tree_cache_memory_mb = rs_pb.tree_cache_memory_mb();
+    }
+    if (rs_pb.landmark_count() != 0) {
+        rs.landmark_count = rs_pb.landmark_count();
+    }
+    rs.vertex_order = static_cast<router::VertexOrder>(rs_pb.vertex_order());
+    if (rs_pb.walk_velocity() != 0) {
+        rs.walk_velocity = rs_pb.walk_velocity();
+    }
+    if (rs_pb.nearest_stop_count() != 0) {
+        rs.nearest_stop_count = rs_pb.nearest_stop_count();
+    }
 
     req_handler_.SetRoutingSettings(rs);
 }
 
+void Serialization::DeserializeRouter(const transport_catalogue_serialize::TransportRouter &tr_pb) {
+    // Данные маршрутизатора проверяются до построения: индексы из повреждённой базы
+    // вышли бы за границы графа и справочника
+    const auto corrupted = []() {
+        return invalid_argument("Router data in the database is corrupted"s);
+    };
+
+    const auto& graph_pb = tr_pb.graph();
+    const auto& buses = db_.GetAllBuses();
+    const size_t vertex_count = graph_pb.vertex_count();
+    if (vertex_count != db_.GetAllStops().size() * 2 || tr_pb.edges_path_data_size() != graph_pb.edges_size()) {
+        throw corrupted();
+    }
+
+    router::TransportRouter::Graph graph(vertex_count);
+    for (const auto& edge_pb : graph_pb.edges()) {
+        if (edge_pb.from() >= vertex_count || edge_pb.to() >= vertex_count) {
+            throw corrupted();
+        }
+        graph.AddEdge({edge_pb.from(), edge_pb.to(), edge_pb.weight()});
+    }
+
+    router::TransportRouter::EdgeSources edge_sources;
+    edge_sources.reserve(tr_pb.edges_path_data_size());
+    for (int i = 0; i < tr_pb.edges_path_data_size(); ++i) {
+        const auto& item_pb = tr_pb.edges_path_data(i);
+        if (item_pb.has_bus()) {
+            if (item_pb.bus().bus_index() >= buses.size() || item_pb.bus().span_count() <= 0) {
+                throw corrupted();
+            }
+            edge_sources.push_back({RouteItemKind::BUS, item_pb.bus().bus_index(),
+                                    static_cast<uint32_t>(item_pb.bus().span_count()), graph_pb.edges(i).meters()});
+        } else if (item_pb.has_wait()) {
+            if (item_pb.wait().stop_index() >= db_.GetAllStops().size()) {
+                throw corrupted();
+            }
+            edge_sources.push_back({RouteItemKind::WAIT, item_pb.wait().stop_index(), 0, 0});
+        } else {
+            throw corrupted();
+        }
+    }
+
+    vector<uint32_t> stop_positions(tr_pb.stop_positions().begin(), tr_pb.stop_positions().end());
+    transport_router_.LoadGraph(move(graph), move(edge_sources), move(stop_positions));
+    transport_router_.ComputeGeoLowerBound(buses, db_.GetDistancesMap());
+    const auto& loaded_graph = transport_router_.GetGraph();
+
+    if (tr_pb.has_routes_internal_data()) {
+        const auto& routes_pb = tr_pb.routes_internal_data();
+        const size_t cell_count = vertex_count * vertex_count;
+        if (static_cast<size_t>(routes_pb.weight_size()) != cell_count ||
+            static_cast<size_t>(routes_pb.prev_edge_size()) != cell_count) {
+            throw corrupted();
+        }
+        graph::Router<double>::RoutesInternalData routes_internal_data(
+                vertex_count, vector<optional<graph::Router<double>::RouteInternalData>>(vertex_count));
+        for (size_t from = 0; from < vertex_count; ++from) {
+            for (size_t to = 0; to < vertex_count; ++to) {
+                const size_t index = from * vertex_count + to;
+                if (routes_pb.weight(index) == numeric_limits<double>::infinity()) {
+                    continue;
+                }
+                auto& route = routes_internal_data[from][to];
+                route.emplace();
+                route->weight = routes_pb.weight(index);
+                if (routes_pb.prev_edge(index) != 0) {
+                    route->prev_edge = routes_pb.prev_edge(index) - 1;
+                }
+            }
+        }
+        transport_router_.SetRouter(make_unique<graph::Router<double>>(loaded_graph, move(routes_internal_data)));
+    } else if (tr_pb.has_contraction_hierarchy()) {
+        using ContractionHierarchyRouter = graph::ContractionHierarchyRouter<double>;
+        const auto& ch_pb = tr_pb.contraction_hierarchy();
+
+        if (static_cast<size_t>(ch_pb.ranks_size()) != vertex_count) {
+            throw corrupted();
+        }
+        vector<size_t> ranks(ch_pb.ranks().begin(), ch_pb.ranks().end());
+        vector<ContractionHierarchyRouter::HierarchyEdge> edges;
+        edges.reserve(ch_pb.edges_size());
+        for (const auto& edge_pb : ch_pb.edges()) {
+            ContractionHierarchyRouter::HierarchyEdge edge{edge_pb.from(), edge_pb.to(), edge_pb.weight()};
+            if (edge_pb.original_edge() != 0) {
+                edge.original_edge = edge_pb.original_edge() - 1;
+            } else {
+                edge.lower_edge = edge_pb.lower_edge();
+                edge.upper_edge = edge_pb.upper_edge();
+            }
+            edges.push_back(edge);
+        }
+        transport_router_.SetRouter(
+                make_unique<ContractionHierarchyRouter>(loaded_graph, move(ranks), move(edges)));
+    } else if (tr_pb.has_compact_routes_data()) {
+        const auto& compact_pb = tr_pb.compact_routes_data();
+        vector<float> weights(compact_pb.weights().begin(), compact_pb.weights().end());
+        vector<uint32_t> prev_edges(compact_pb.prev_edges().begin(), compact_pb.prev_edges().end());
+        transport_router_.SetRouter(
+                make_unique<graph::CompactRouter<double>>(loaded_graph, move(weights), move(prev_edges)));
+    } else if (tr_pb.has_landmarks()) {
+        const auto& landmarks_pb = tr_pb.landmarks();
+        const size_t table_size = vertex_count * landmarks_pb.landmarks_size();
+        if (static_cast<size_t>(landmarks_pb.distances_from_size()) != table_size ||
+            static_cast<size_t>(landmarks_pb.distances_to_size()) != table_size) {
+            throw corrupted();
+        }
+        vector<graph::VertexId> landmarks(landmarks_pb.landmarks().begin(), landmarks_pb.landmarks().end());
+        vector<double> distances_from(landmarks_pb.distances_from().begin(), landmarks_pb.distances_from().end());
+        vector<double> distances_to(landmarks_pb.distances_to().begin(), landmarks_pb.distances_to().end());
+        transport_router_.SetRouter(make_unique<graph::AStarRouter<double>>(
+                loaded_graph, transport_router_.MakeGeoLowerBound(), move(landmarks),
+                move(distances_from), move(distances_to)));
+    } else if (tr_pb.has_hub_labels()) {
+        transport_router_.SetRouter(make_unique<graph::HubLabelRouter<double>>(
+                loaded_graph, DeserializeLabels(tr_pb.hub_labels().forward()),
+                DeserializeLabels(tr_pb.hub_labels().backward())));
+    } else {
+        transport_router_.BuildRouter();
+    }
+}
+
+void Serialization::SerializeRouter(transport_catalogue_serialize::TransportRouter &tr_pb,
+                                    size_t reserved_bytes) const {
+    const auto& graph = transport_router_.GetGraph();
+    auto& graph_pb = *tr_pb.mutable_graph();
+    graph_pb.set_vertex_count(graph.GetVertexCount());
+    const auto& edge_sources = transport_router_.GetEdgeSources();
+    for (graph::EdgeId id = 0; id < graph.GetEdgeCount(); ++id) {
+        const auto& edge = graph.GetEdge(id);
+        auto& edge_pb = *graph_pb.add_edges();
+        edge_pb.set_from(edge.from);
+        edge_pb.set_to(edge.to);
+        edge_pb.set_weight(edge.weight);
+        edge_pb.set_meters(edge_sources[id].meters);
+    }
+
+    for (const auto& edge_source : edge_sources) {
+        auto& item_pb = *tr_pb.add_edges_path_data();
+        if (edge_source.kind == RouteItemKind::BUS) {
+            item_pb.mutable_bus()->set_bus_index(edge_source.id);
+            item_pb.mutable_bus()->set_span_count(edge_source.span_count);
+        } else {
+            item_pb.mutable_wait()->set_stop_index(edge_source.id);
+        }
+    }
+
+    for (const uint32_t position : transport_router_.GetStopPositions()) {
+        tr_pb.add_stop_positions(position);
+    }
+
+    // Таблицы всех пар оцениваются сверху до заполнения, чтобы не собирать в памяти
+    // сообщение, которое всё равно нельзя записать
+    const size_t vertex_count = graph.GetVertexCount();
+    const size_t cell_count = vertex_count * vertex_count;
+    const size_t available_bytes = MAX_DATABASE_BYTES - min(MAX_DATABASE_BYTES, reserved_bytes + tr_pb.ByteSizeLong());
+    const auto fits = [&](size_t cell_bytes) {
+        if (cell_count <= available_bytes / cell_bytes) {
+            return true;
+        }
+        cerr << "Warning: the route table for "sv << vertex_count << " vertices exceeds the serialization limit; "sv
+             << "it is not saved and will be rebuilt when requests are processed"sv << endl;
+        return false;
+    };
+
+    const auto* router = transport_router_.GetRouter();
+    if (const auto* all_pairs_router = dynamic_cast<const graph::Router<double>*>(router)) {
+        if (!fits(sizeof(double) + GetVarintSize(graph.GetEdgeCount()))) {
+            return;
+        }
+        auto& routes_pb = *tr_pb.mutable_routes_internal_data();
+        routes_pb.mutable_weight()->Reserve(cell_count);
+        routes_pb.mutable_prev_edge()->Reserve(cell_count);
+        for (const auto& row : all_pairs_router->GetRoutesInternalData()) {
+            for (const auto& route : row) {
+                routes_pb.add_weight(route ? route->weight : numeric_limits<double>::infinity());
+                routes_pb.add_prev_edge(route && route->prev_edge ? *route->prev_edge + 1 : 0);
+            }
+        }
+    } else if (const auto* ch_router = dynamic_cast<const graph::ContractionHierarchyRouter<double>*>(router)) {
+        auto& ch_pb = *tr_pb.mutable_contraction_hierarchy();
+        for (const size_t rank : ch_router->GetRanks()) {
+            ch_pb.add_ranks(rank);
+        }
+        for (const auto& edge : ch_router->GetHierarchyEdges()) {
+            auto& edge_pb = *ch_pb.add_edges();
+            edge_pb.set_from(edge.from);
+            edge_pb.set_to(edge.to);
+            edge_pb.set_weight(edge.weight);
+            if (edge.original_edge != graph::ContractionHierarchyRouter<double>::NO_EDGE) {
+                edge_pb.set_original_edge(edge.original_edge + 1);
+            } else {
+                edge_pb.set_lower_edge(edge.lower_edge);
+                edge_pb.set_upper_edge(edge.upper_edge);
+            }
+        }
+    } else if (const auto* compact_router = dynamic_cast<const graph::CompactRouter<double>*>(router)) {
+        if (!fits(sizeof(float) + GetVarintSize(numeric_limits<uint32_t>::max()))) {
+            return;
+        }
+        auto& compact_pb = *tr_pb.mutable_compact_routes_data();
+        const auto& weights = compact_router->GetWeights();
+        const auto& prev_edges = compact_router->GetPrevEdges();
+        compact_pb.mutable_weights()->Add(weights.begin(), weights.end());
+        compact_pb.mutable_prev_edges()->Add(prev_edges.begin(), prev_edges.end());
+    } else if (const auto* astar_router = dynamic_cast<const graph::AStarRouter<double>*>(router)) {
+        // Без ориентиров (ASTAR) хранить нечего: географическая оценка считается по справочнику
+        if (!astar_router->GetLandmarks().empty()) {
+            auto& landmarks_pb = *tr_pb.mutable_landmarks();
+            const auto& landmarks = astar_router->GetLandmarks();
+            const auto& distances_from = astar_router->GetDistancesFromLandmarks();
+            const auto& distances_to = astar_router->GetDistancesToLandmarks();
+            landmarks_pb.mutable_landmarks()->Add(landmarks.begin(), landmarks.end());
+            landmarks_pb.mutable_distances_from()->Add(distances_from.begin(), distances_from.end());
+            landmarks_pb.mutable_distances_to()->Add(distances_to.begin(), distances_to.end());
+        }
+    } else if (const auto* hub_label_router = dynamic_cast<const graph::HubLabelRouter<double>*>(router)) {
+        auto& hub_labels_pb = *tr_pb.mutable_hub_labels();
+        SerializeLabels(*hub_labels_pb.mutable_forward(), hub_label_router->GetForwardLabels());
+        SerializeLabels(*hub_labels_pb.mutable_backward(), hub_label_router->GetBackwardLabels());
+    }
+}
+
+void Serialization::SerializeLabels(transport_catalogue_serialize::Labels &labels_pb,
+                                    const graph::HubLabelRouter<double>::Labels &labels) const {
+    labels_pb.mutable_offsets()->Add(labels.offsets.begin(), labels.offsets.end());
+    labels_pb.mutable_hubs()->Reserve(labels.entries.size());
+    labels_pb.mutable_weights()->Reserve(labels.entries.size());
+    labels_pb.mutable_edges()->Reserve(labels.entries.size());
+    for (const auto& entry : labels.entries) {
+        labels_pb.add_hubs(entry.hub);
+        labels_pb.add_weights(entry.weight);
+        labels_pb.add_edges(entry.edge);
+    }
+}
+
+graph::HubLabelRouter<double>::Labels Serialization::DeserializeLabels(
+        const transport_catalogue_serialize::Labels &labels_pb) const {
+    if (labels_pb.hubs_size() != labels_pb.weights_size() || labels_pb.hubs_size() != labels_pb.edges_size()) {
+        throw invalid_argument("Hub labels are corrupted"s);
+    }
+    graph::HubLabelRouter<double>::Labels labels;
+    labels.offsets.assign(labels_pb.offsets().begin(), labels_pb.offsets().end());
+    labels.entries.reserve(labels_pb.hubs_size());
+    for (int i = 0; i < labels_pb.hubs_size(); ++i) {
+        labels.entries.push_back({labels_pb.hubs(i), labels_pb.weights(i), labels_pb.edges(i)});
+    }
+    return labels;
+}
+
 void Serialization::SerializeBaseData(transport_catalogue_serialize::TransportCatalogue &tc_pb,
                                       const std::vector<json::Node>& base_requests) const {
     for (const auto& base_request : base_requests) {
@@ -231,9 +552,15 @@ void Serialization::SerializeRenderSettings(transport_catalogue_serialize::Rende
 }
 
 void Serialization::SerializeRoutingSettings(transport_catalogue_serialize::RoutingSettings &rs_pb,
-                                             const json::Dict &routing_settings) const {
-    rs_pb.set_bus_velocity(routing_settings.at("bus_velocity"s).AsInt());
-    rs_pb.set_bus_wait_time(routing_settings.at("bus_wait_time"s).AsInt());
+                                             const router::RoutingSettings &routing_settings) const {
+    rs_pb.set_bus_velocity(routing_settings.bus_velocity);
+    rs_pb.set_bus_wait_time(routing_settings.bus_wait_time);
+    rs_pb.set_router_type(static_cast<transport_catalogue_serialize::RouterType>(routing_settings.router_type));
+    rs_pb.set_tree_cache_memory_mb(routing_settings.tree_cache_memory_mb);
+    rs_pb.set_landmark_count(routing_settings.landmark_count);
+    rs_pb.set_vertex_order(static_cast<transport_catalogue_serialize::VertexOrder>(routing_settings.vertex_order));
+    rs_pb.set_walk_velocity(routing_settings.walk_velocity);
+    rs_pb.set_nearest_stop_count(routing_settings.nearest_stop_count);
 }
 
 void Serialization::SetSerializationColor(transport_catalogue_serialize::Color &color_pb,const svg::Color color) const {
@@ -13,14 +13,16 @@
 #include <unordered_map>
 #include <map>
 #include <stdexcept>
+#include <limits>
 
 namespace transport_catalogue::serialization {
 
     class Serialization {
     public:
-        Serialization(TransportCatalogue &db, RequestHandler &req_handler);
+        Serialization(TransportCatalogue &db, RequestHandler &req_handler,
+                      router::TransportRouter &transport_router);
 
-        void MakeBase(std::istream &input) const;
+        void MakeBase(std::istream &input);
         void ProcessRequests(std::istream &input, std::ostream &out);
     private:
         void SetSerializationColor(transport_catalogue_serialize::Color& color_pb,svg::Color color) const;
@@ -32,11 +34,21 @@ namespace transport_catalogue::serialization {
         void SerializeRenderSettings(transport_catalogue_serialize::RenderSettings &rs_pb, const json::Dict & render_settings) const;
         void DeserializeRenderSettings(const transport_catalogue_serialize::RenderSettings& rs_pb);
 
-        void SerializeRoutingSettings(transport_catalogue_serialize::RoutingSettings &rs_pb, const json::Dict& routing_settings) const;
+        void SerializeRoutingSettings(transport_catalogue_serialize::RoutingSettings &rs_pb, const router::RoutingSettings& routing_settings) const;
         void DeserializeRoutingSettings(const transport_catalogue_serialize::RoutingSettings& rs_pb);
 
+        // reserved_bytes - размер остальной базы: таблицы, с которыми база превысит предел protobuf,
+        // не сохраняются, и маршрутизатор строится заново при обработке запросов
+        void SerializeRouter(transport_catalogue_serialize::TransportRouter &tr_pb, size_t reserved_bytes) const;
+        void DeserializeRouter(const transport_catalogue_serialize::TransportRouter &tr_pb);
+
+        void SerializeLabels(transport_catalogue_serialize::Labels &labels_pb,
+                             const graph::HubLabelRouter<double>::Labels &labels) const;
+        graph::HubLabelRouter<double>::Labels DeserializeLabels(const transport_catalogue_serialize::Labels &labels_pb) const;
+
         TransportCatalogue &db_;
         RequestHandler &req_handler_;
+        router::TransportRouter &transport_router_;
     };
 
 } // namespace transport_catalogue::serialization
\ No newline at end of file
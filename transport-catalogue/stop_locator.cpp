@@ -0,0 +1,129 @@
+#define _USE_MATH_DEFINES
+#include "stop_locator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+using namespace std;
+
+namespace transport_catalogue
+{
+    StopLocator::StopLocator(vector<const Stop *> stops) : stops_(move(stops))
+    {
+        if (stops_.empty())
+            return;
+
+        double lat_sum = 0;
+        for (const Stop *stop : stops_)
+            lat_sum += stop->coord.lat;
+        mean_lat_cos_ = cos(lat_sum / static_cast<double>(stops_.size()) * M_PI / 180.);
+
+        points_.reserve(stops_.size());
+        for (const Stop *stop : stops_)
+            points_.push_back(Project(stop->coord));
+        Build(0, stops_.size(), 0);
+    }
+
+    bool StopLocator::IsEmpty() const
+    {
+        return stops_.empty();
+    }
+
+    StopLocator::Point StopLocator::Project(const geo::Coordinates &coord) const
+    {
+        static const double meters_per_degree = M_PI / 180. * geo::EARTH_RADIUS;
+        return {coord.lng * mean_lat_cos_ * meters_per_degree, coord.lat * meters_per_degree};
+    }
+
+    void StopLocator::Build(size_t begin, size_t end, size_t depth)
+    {
+        if (end - begin <= 1)
+            return;
+
+        // Остановки и их точки переставляются вместе, поэтому сортируются позиции
+        vector<size_t> positions(end - begin);
+        iota(positions.begin(), positions.end(), begin);
+        const size_t middle = (end - begin) / 2;
+        const bool by_x = depth % 2 == 0;
+        nth_element(positions.begin(), positions.begin() + middle, positions.end(),
+                    [this, by_x](size_t lhs, size_t rhs)
+                    { return by_x ? points_[lhs].x < points_[rhs].x : points_[lhs].y < points_[rhs].y; });
+
+        vector<const Stop *> stops(positions.size());
+        vector<Point> points(positions.size());
+        for (size_t i = 0; i < positions.size(); ++i)
+        {
+            stops[i] = stops_[positions[i]];
+            points[i] = points_[positions[i]];
+        }
+        copy(stops.begin(), stops.end(), stops_.begin() + begin);
+        copy(points.begin(), points.end(), points_.begin() + begin);
+
+        Build(begin, begin + middle, depth + 1);
+        Build(begin + middle + 1, end, depth + 1);
+    }
+
+    void StopLocator::Search(size_t begin, size_t end, size_t depth, const Point &point, size_t count,
+                             vector<Candidate> &candidates) const
+    {
+        if (begin >= end)
+            return;
+
+        const size_t middle = begin + (end - begin) / 2;
+        const Point &node = points_[middle];
+        const double dx = point.x - node.x;
+        const double dy = point.y - node.y;
+
+        // candidates - куча с самым дальним из найденных кандидатов на вершине
+        const Candidate candidate{dx * dx + dy * dy, middle};
+        if (candidates.size() < count)
+        {
+            candidates.push_back(candidate);
+            push_heap(candidates.begin(), candidates.end());
+        }
+        else if (candidate < candidates.front())
+        {
+            pop_heap(candidates.begin(), candidates.end());
+            candidates.back() = candidate;
+            push_heap(candidates.begin(), candidates.end());
+        }
+
+        // Сначала поддерево со стороны точки; второе - только если разделяющая прямая ближе худшего кандидата
+        const double split_distance = depth % 2 == 0 ? dx : dy;
+        const bool point_on_left = split_distance < 0;
+        if (point_on_left)
+            Search(begin, middle, depth + 1, point, count, candidates);
+        else
+            Search(middle + 1, end, depth + 1, point, count, candidates);
+
+        if (candidates.size() < count || split_distance * split_distance < candidates.front().squared_distance)
+        {
+            if (point_on_left)
+                Search(middle + 1, end, depth + 1, point, count, candidates);
+            else
+                Search(begin, middle, depth + 1, point, count, candidates);
+        }
+    }
+
+    vector<NearestStop> StopLocator::FindNearest(const geo::Coordinates &point, size_t count) const
+    {
+        if (count == 0 || stops_.empty())
+            return {};
+
+        vector<Candidate> candidates;
+        candidates.reserve(count);
+        Search(0, stops_.size(), 0, Project(point), count, candidates);
+
+        vector<NearestStop> res;
+        res.reserve(candidates.size());
+        for (const Candidate &candidate : candidates)
+        {
+            const Stop *stop = stops_[candidate.position];
+            res.push_back({stop, geo::ComputeDistance(point, stop->coord)});
+        }
+        sort(res.begin(), res.end(), [](const NearestStop &lhs, const NearestStop &rhs)
+             { return lhs.distance < rhs.distance; });
+        return res;
+    }
+} // namespace transport_catalogue
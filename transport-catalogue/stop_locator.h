@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+
+#include "domain.h"
+#include "geo.h"
+
+namespace transport_catalogue
+{
+    // Остановка рядом с точкой и расстояние до неё по прямой в метрах
+    struct NearestStop
+    {
+        const Stop *stop;
+        double distance;
+    };
+
+    // Пространственный индекс остановок: неявное k-d дерево по координатам, спроецированным
+    // на плоскость в метрах (равнопромежуточная проекция вокруг средней широты). В пределах
+    // города искажение проекции мало, а итоговые расстояния считаются geo::ComputeDistance
+    class StopLocator
+    {
+    public:
+        explicit StopLocator(std::vector<const Stop *> stops);
+
+        // Не более count ближайших к point остановок в порядке возрастания расстояния
+        std::vector<NearestStop> FindNearest(const geo::Coordinates &point, size_t count) const;
+
+        bool IsEmpty() const;
+
+    private:
+        struct Point
+        {
+            double x;
+            double y;
+        };
+
+        // Кандидат поиска: квадрат расстояния на плоскости и позиция в stops_
+        struct Candidate
+        {
+            double squared_distance;
+            size_t position;
+
+            bool operator<(const Candidate &other) const
+            {
+                return squared_distance < other.squared_distance;
+            }
+        };
+
+        Point Project(const geo::Coordinates &coord) const;
+        // Поддерево [begin, end) с корнем в середине делится по x на чётной глубине, по y - на нечётной
+        void Build(size_t begin, size_t end, size_t depth);
+        void Search(size_t begin, size_t end, size_t depth, const Point &point, size_t count,
+                    std::vector<Candidate> &candidates) const;
+
+        double mean_lat_cos_ = 1;
+        std::vector<const Stop *> stops_;
+        std::vector<Point> points_;
+    };
+} // namespace transport_catalogue
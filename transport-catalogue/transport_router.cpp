@@ -1,5 +1,8 @@
 #include "transport_router.h"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <numeric>
 
 using namespace std;
 using namespace graph;
@@ -8,11 +11,161 @@ namespace transport_catalogue
 {
     namespace router
     {
+        RouterType ParseRouterType(string_view router_type)
+        {
+            if (router_type == "all_pairs"sv)
+                return RouterType::ALL_PAIRS;
+            if (router_type == "all_pairs_blocked"sv)
+                return RouterType::ALL_PAIRS_BLOCKED;
+            if (router_type == "all_pairs_dijkstra"sv)
+                return RouterType::ALL_PAIRS_DIJKSTRA;
+            if (router_type == "all_pairs_compact"sv)
+                return RouterType::ALL_PAIRS_COMPACT;
+            if (router_type == "tree_cache"sv)
+                return RouterType::TREE_CACHE;
+            if (router_type == "dijkstra"sv)
+                return RouterType::DIJKSTRA;
+            if (router_type == "contraction_hierarchies"sv)
+                return RouterType::CONTRACTION_HIERARCHIES;
+            if (router_type == "hub_labels"sv)
+                return RouterType::HUB_LABELS;
+            if (router_type == "raptor"sv)
+                return RouterType::RAPTOR;
+            if (router_type == "astar"sv)
+                return RouterType::ASTAR;
+            if (router_type == "alt"sv)
+                return RouterType::ALT;
+
+            throw invalid_argument("Unknown router type: "s + string(router_type));
+        }
+
+        string_view GetRouterTypeName(RouterType router_type)
+        {
+            switch (router_type)
+            {
+            case RouterType::ALL_PAIRS:
+                return "all_pairs"sv;
+            case RouterType::ALL_PAIRS_BLOCKED:
+                return "all_pairs_blocked"sv;
+            case RouterType::ALL_PAIRS_DIJKSTRA:
+                return "all_pairs_dijkstra"sv;
+            case RouterType::ALL_PAIRS_COMPACT:
+                return "all_pairs_compact"sv;
+            case RouterType::TREE_CACHE:
+                return "tree_cache"sv;
+            case RouterType::DIJKSTRA:
+                return "dijkstra"sv;
+            case RouterType::CONTRACTION_HIERARCHIES:
+                return "contraction_hierarchies"sv;
+            case RouterType::HUB_LABELS:
+                return "hub_labels"sv;
+            case RouterType::RAPTOR:
+                return "raptor"sv;
+            case RouterType::ASTAR:
+                return "astar"sv;
+            case RouterType::ALT:
+                return "alt"sv;
+            }
+            return {};
+        }
+
+        VertexOrder ParseVertexOrder(string_view vertex_order)
+        {
+            if (vertex_order == "catalogue"sv)
+                return VertexOrder::CATALOGUE;
+            if (vertex_order == "rcm"sv)
+                return VertexOrder::RCM;
+            if (vertex_order == "hilbert"sv)
+                return VertexOrder::HILBERT;
+
+            throw invalid_argument("Unknown vertex order: "s + string(vertex_order));
+        }
+
         TransportRouter::TransportRouter(RoutingSettings &routing_settings) : routing_settings_(move(routing_settings)) {}
 
         void TransportRouter::SetOrUpdateRoutingSettings(RoutingSettings &settings)
         {
+            const optional<RoutingSettings> old_settings = routing_settings_;
             routing_settings_ = move(settings);
+            if (!old_settings || vertex_amount_ == 0)
+                return;
+
+            const RoutingSettings &new_settings = *routing_settings_;
+            const bool uses_raptor = new_settings.router_type == RouterType::RAPTOR;
+            if (uses_raptor != ((*old_settings).router_type == RouterType::RAPTOR))
+            {
+                // RAPTOR и графовые маршрутизаторы строятся по разным данным, поэтому переход
+                // между ними требует полной перестройки при следующем запросе
+                ResetGraph();
+                return;
+            }
+
+            if (!uses_raptor && (*old_settings).vertex_order != new_settings.vertex_order)
+            {
+                // Новый порядок меняет номера всех вершин, граф строится заново при следующем запросе
+                ResetGraph();
+                return;
+            }
+
+            if (uses_raptor)
+            {
+                raptor_router_ptr_->SetRoutingSettings(GetBusMultiplier(), new_settings.bus_wait_time);
+                return;
+            }
+
+            const bool weights_changed = (*old_settings).bus_velocity != new_settings.bus_velocity ||
+                                         (*old_settings).bus_wait_time != new_settings.bus_wait_time;
+            if (weights_changed)
+                ReweightGraph();
+
+            if (weights_changed ||
+                (*old_settings).router_type != new_settings.router_type ||
+                (*old_settings).tree_cache_memory_mb != new_settings.tree_cache_memory_mb ||
+                (*old_settings).landmark_count != new_settings.landmark_count)
+                BuildRouter();
+        }
+
+        double TransportRouter::GetBusMultiplier() const
+        {
+            return 1.0 / METERS_IN_KM / (*routing_settings_).bus_velocity * MINUTES_IN_HOUR;
+        }
+
+        double TransportRouter::GetWalkTime(double meters) const
+        {
+            return meters / METERS_IN_KM / (*routing_settings_).walk_velocity * MINUTES_IN_HOUR;
+        }
+
+        size_t TransportRouter::GetNearestStopCount() const
+        {
+            return static_cast<size_t>(max((*routing_settings_).nearest_stop_count, 0));
+        }
+
+        double TransportRouter::GetEdgeWeight(const EdgeSource &edge_source) const
+        {
+            if (edge_source.kind == RouteItemKind::WAIT)
+                return (*routing_settings_).bus_wait_time;
+            return edge_source.meters * GetBusMultiplier();
+        }
+
+        void TransportRouter::ReweightGraph()
+        {
+            for (EdgeId id = 0; id < graph_.GetEdgeCount(); ++id)
+            {
+                graph_.SetEdgeWeight(id, GetEdgeWeight(edge_sources_[id]));
+            }
+        }
+
+        void TransportRouter::ResetGraph()
+        {
+            router_ptr_.reset();
+            raptor_router_ptr_.reset();
+            bounded_search_ = make_unique<LazyBoundedSearch>();
+            vertex_amount_ = 0;
+            graph_ = Graph();
+            component_labels_ = ComponentLabels();
+            edge_sources_.clear();
+            stop_positions_.clear();
+            stops_by_position_.clear();
         }
 
         bool TransportRouter::HasRoutingSettings() const
@@ -33,36 +186,671 @@ namespace transport_catalogue
         void TransportRouter::FillDataToGraph(const deque<Bus> &buses,
                                               const DictStopsPairToDistances &distances_map)
         {
-            for (const Bus &bus : buses)
+            BuildGraph(buses, distances_map);
+            BuildRouter();
+        }
+
+        void TransportRouter::BuildGraph(const deque<Bus> &buses,
+                                         const DictStopsPairToDistances &distances_map)
+        {
+            if ((*routing_settings_).router_type == RouterType::RAPTOR)
+            {
+                raptor_router_ptr_ = make_unique<RaptorRouter>(
+                    buses, distances_map, GetBusMultiplier(), (*routing_settings_).bus_wait_time);
+                return;
+            }
+
+            ComputeStopPositions(buses);
+
+            ParallelEdges parallel_edges;
+            for (uint32_t bus_index = 0; bus_index < buses.size(); ++bus_index)
             {
-                AddBusToGraph(bus.name, bus.route.begin(), bus.route.end(), distances_map);
+                const Bus &bus = buses[bus_index];
+                AddBusToGraph(bus_index, bus.route.begin(), bus.route.end(), distances_map, parallel_edges);
 
                 if (!bus.is_roundtrip)
                 {
-                    AddBusToGraph(bus.name, bus.route.rbegin(), bus.route.rend(), distances_map);
+                    AddBusToGraph(bus_index, bus.route.rbegin(), bus.route.rend(), distances_map, parallel_edges);
                 }
             }
-            router_ptr_ = make_unique<Router<double>>(graph_);
+            component_labels_ = ComponentLabels(graph_);
+            ComputeGeoLowerBound(buses, distances_map);
         }
 
-        optional<PathData> TransportRouter::GetShortWayBetween(Stop *start_stop, Stop *end_stop)
+        void TransportRouter::ComputeStopPositions(const deque<Bus> &buses)
         {
-            auto ans = router_ptr_->BuildRoute(start_stop->id, end_stop->id);
+            vector<uint32_t> stops_by_position;
+            switch ((*routing_settings_).vertex_order)
+            {
+            case VertexOrder::CATALOGUE:
+                break;
+            case VertexOrder::RCM:
+                stops_by_position = MakeCuthillMcKeeOrder(buses);
+                break;
+            case VertexOrder::HILBERT:
+                stops_by_position = MakeHilbertOrder(buses);
+                break;
+            }
 
-            if (!ans.has_value())
-                return nullopt;
+            const size_t stop_count = vertex_amount_ / 2;
+            vector<bool> placed(stop_count, false);
+            for (const uint32_t stop_index : stops_by_position)
+                placed[stop_index] = true;
+            for (uint32_t stop_index = 0; stop_index < stop_count; ++stop_index)
+            {
+                if (!placed[stop_index])
+                    stops_by_position.push_back(stop_index);
+            }
+            SetStopsOrder(move(stops_by_position));
+        }
 
-            PathData res;
+        vector<uint32_t> TransportRouter::MakeCuthillMcKeeOrder(const deque<Bus> &buses) const
+        {
+            const size_t stop_count = vertex_amount_ / 2;
+            vector<vector<uint32_t>> neighbours(stop_count);
+            for (const Bus &bus : buses)
+            {
+                for (size_t i = 1; i < bus.route.size(); ++i)
+                {
+                    const uint32_t from = GetStopIndex(*bus.route[i - 1]);
+                    const uint32_t to = GetStopIndex(*bus.route[i]);
+                    if (from == to)
+                        continue;
+                    neighbours[from].push_back(to);
+                    neighbours[to].push_back(from);
+                }
+            }
+            for (auto &stop_neighbours : neighbours)
+            {
+                sort(stop_neighbours.begin(), stop_neighbours.end());
+                stop_neighbours.erase(unique(stop_neighbours.begin(), stop_neighbours.end()), stop_neighbours.end());
+            }
+            const auto by_degree = [&neighbours](uint32_t lhs, uint32_t rhs)
+            {
+                return neighbours[lhs].size() < neighbours[rhs].size();
+            };
+
+            // Обход в ширину начинается в каждой компоненте с остановки наименьшей степени,
+            // соседи добавляются в порядке возрастания степени
+            vector<uint32_t> roots;
+            for (uint32_t stop_index = 0; stop_index < stop_count; ++stop_index)
+            {
+                if (!neighbours[stop_index].empty())
+                    roots.push_back(stop_index);
+            }
+            stable_sort(roots.begin(), roots.end(), by_degree);
 
-            res.total_time = (*ans).weight;
-            if (res.total_time == 0)
+            vector<uint32_t> res;
+            vector<bool> visited(stop_count, false);
+            for (const uint32_t root : roots)
+            {
+                if (visited[root])
+                    continue;
+                visited[root] = true;
+                res.push_back(root);
+                for (size_t head = res.size() - 1; head < res.size(); ++head)
+                {
+                    const size_t first_new = res.size();
+                    for (const uint32_t neighbour : neighbours[res[head]])
+                    {
+                        if (visited[neighbour])
+                            continue;
+                        visited[neighbour] = true;
+                        res.push_back(neighbour);
+                    }
+                    stable_sort(res.begin() + first_new, res.end(), by_degree);
+                }
+            }
+            reverse(res.begin(), res.end());
+            return res;
+        }
+
+        namespace
+        {
+            // Номер клетки на кривой Гильберта в квадрате side x side, side - степень двойки
+            uint64_t GetHilbertIndex(uint32_t side, uint32_t x, uint32_t y)
+            {
+                uint64_t res = 0;
+                for (uint32_t half = side / 2; half > 0; half /= 2)
+                {
+                    const uint32_t rx = (x & half) > 0 ? 1 : 0;
+                    const uint32_t ry = (y & half) > 0 ? 1 : 0;
+                    res += static_cast<uint64_t>(half) * half * ((3 * rx) ^ ry);
+                    if (ry == 0)
+                    {
+                        if (rx == 1)
+                        {
+                            x = side - 1 - x;
+                            y = side - 1 - y;
+                        }
+                        swap(x, y);
+                    }
+                }
                 return res;
+            }
+        } // namespace
 
-            transform((*ans).edges.begin(), (*ans).edges.end(), back_inserter(res.items),
-                      [&](EdgeId id)
-                      {
-                          return edge_id_to_path_data_.at(id);
-                      });
+        vector<uint32_t> TransportRouter::MakeHilbertOrder(const deque<Bus> &buses) const
+        {
+            static constexpr uint32_t HILBERT_SIDE = 1 << 16;
+
+            vector<const Stop *> stops;
+            vector<bool> added(vertex_amount_ / 2, false);
+            for (const Bus &bus : buses)
+            {
+                for (const Stop *stop : bus.route)
+                {
+                    if (!added[GetStopIndex(*stop)])
+                    {
+                        added[GetStopIndex(*stop)] = true;
+                        stops.push_back(stop);
+                    }
+                }
+            }
+            if (stops.empty())
+                return {};
+
+            geo::Coordinates min_coord = stops.front()->coord;
+            geo::Coordinates max_coord = stops.front()->coord;
+            for (const Stop *stop : stops)
+            {
+                min_coord = {min(min_coord.lat, stop->coord.lat), min(min_coord.lng, stop->coord.lng)};
+                max_coord = {max(max_coord.lat, stop->coord.lat), max(max_coord.lng, stop->coord.lng)};
+            }
+            const auto to_cell = [](double value, double min_value, double max_value)
+            {
+                if (!(max_value > min_value))
+                    return uint32_t{0};
+                return static_cast<uint32_t>((value - min_value) / (max_value - min_value) * (HILBERT_SIDE - 1));
+            };
+
+            vector<pair<uint64_t, uint32_t>> indexed_stops;
+            indexed_stops.reserve(stops.size());
+            for (const Stop *stop : stops)
+            {
+                const uint32_t x = to_cell(stop->coord.lng, min_coord.lng, max_coord.lng);
+                const uint32_t y = to_cell(stop->coord.lat, min_coord.lat, max_coord.lat);
+                indexed_stops.push_back({GetHilbertIndex(HILBERT_SIDE, x, y), GetStopIndex(*stop)});
+            }
+            sort(indexed_stops.begin(), indexed_stops.end());
+
+            vector<uint32_t> res;
+            res.reserve(indexed_stops.size());
+            for (const auto &[hilbert_index, stop_index] : indexed_stops)
+                res.push_back(stop_index);
+            return res;
+        }
+
+        void TransportRouter::SetStopsOrder(vector<uint32_t> stops_by_position)
+        {
+            stops_by_position_ = move(stops_by_position);
+            stop_positions_.assign(stops_by_position_.size(), 0);
+            for (uint32_t position = 0; position < stops_by_position_.size(); ++position)
+                stop_positions_[stops_by_position_[position]] = position;
+        }
+
+        VertexId TransportRouter::GetStopVertex(const Stop *stop) const
+        {
+            return 2 * static_cast<VertexId>(stop_positions_[GetStopIndex(*stop)]);
+        }
+
+        void TransportRouter::AddEdge(VertexId from, VertexId to, const EdgeSource &edge_source,
+                                      ParallelEdges &parallel_edges)
+        {
+            const uint64_t vertices = static_cast<uint64_t>(from) << 32 | to;
+            const auto [it, inserted] = parallel_edges.emplace(vertices, graph_.GetEdgeCount());
+            if (inserted)
+            {
+                graph_.AddEdge({from, to, GetEdgeWeight(edge_source)});
+                edge_sources_.push_back(edge_source);
+            }
+            else if (edge_source.meters < edge_sources_[it->second].meters)
+            {
+                edge_sources_[it->second] = edge_source;
+                graph_.SetEdgeWeight(it->second, GetEdgeWeight(edge_source));
+            }
+        }
+
+        const TransportRouter::Graph &TransportRouter::GetGraph() const
+        {
+            return graph_;
+        }
+
+        const TransportRouter::EdgeSources &TransportRouter::GetEdgeSources() const
+        {
+            return edge_sources_;
+        }
+
+        const vector<uint32_t> &TransportRouter::GetStopPositions() const
+        {
+            return stop_positions_;
+        }
+
+        const graph::RouterBase<double> *TransportRouter::GetRouter() const
+        {
+            return router_ptr_.get();
+        }
+
+        void TransportRouter::LoadGraph(Graph graph, EdgeSources edge_sources, vector<uint32_t> stop_positions)
+        {
+            if (edge_sources.size() != graph.GetEdgeCount())
+                throw invalid_argument("Edge sources don't match the graph");
+
+            const size_t stop_count = graph.GetVertexCount() / 2;
+            if (stop_positions.empty())
+            {
+                stop_positions.resize(stop_count);
+                iota(stop_positions.begin(), stop_positions.end(), 0);
+            }
+            if (stop_positions.size() != stop_count)
+                throw invalid_argument("Stop positions don't match the graph");
+
+            // Позиции должны быть перестановкой: каждая позиция занята ровно одной остановкой
+            vector<uint32_t> stops_by_position(stop_count, 0);
+            vector<bool> occupied(stop_count, false);
+            for (uint32_t stop_index = 0; stop_index < stop_count; ++stop_index)
+            {
+                const uint32_t position = stop_positions[stop_index];
+                if (position >= stop_count || occupied[position])
+                    throw invalid_argument("Stop positions don't match the graph");
+                occupied[position] = true;
+                stops_by_position[position] = stop_index;
+            }
+
+            router_ptr_.reset();
+            bounded_search_ = make_unique<LazyBoundedSearch>();
+            graph_ = move(graph);
+            vertex_amount_ = graph_.GetVertexCount();
+            component_labels_ = ComponentLabels(graph_);
+            edge_sources_ = move(edge_sources);
+            SetStopsOrder(move(stops_by_position));
+        }
+
+        void TransportRouter::ComputeGeoLowerBound(const deque<Bus> &buses,
+                                                   const DictStopsPairToDistances &distances_map)
+        {
+            vertex_coordinates_.assign(vertex_amount_, {0, 0});
+            double min_distances_ratio = numeric_limits<double>::infinity();
+            const auto add_segment = [&](Stop *from, Stop *to)
+            {
+                const double geo_distance = geo::ComputeHaversineDistance(from->coord, to->coord);
+                if (!(geo_distance > 0))
+                    return;
+
+                double road_distance = 0;
+                if (distances_map.count({from, to}) > 0)
+                    road_distance = distances_map.at({from, to});
+                else if (distances_map.count({to, from}) > 0)
+                    road_distance = distances_map.at({to, from});
+                min_distances_ratio = min(min_distances_ratio, road_distance / geo_distance);
+            };
+
+            for (const Bus &bus : buses)
+            {
+                for (size_t i = 0; i < bus.route.size(); ++i)
+                {
+                    const Stop *stop = bus.route[i];
+                    const VertexId stop_vertex = GetStopVertex(stop);
+                    vertex_coordinates_[stop_vertex] = vertex_coordinates_[stop_vertex + 1] = stop->coord;
+                    if (i == 0)
+                        continue;
+
+                    add_segment(bus.route[i - 1], bus.route[i]);
+                    if (!bus.is_roundtrip)
+                        add_segment(bus.route[i], bus.route[i - 1]);
+                }
+            }
+
+            if (min_distances_ratio == numeric_limits<double>::infinity())
+                min_distances_ratio = 0;
+            geo_distances_ratio_ = min_distances_ratio;
+        }
+
+        AStarRouter<double>::LowerBound TransportRouter::MakeGeoLowerBound() const
+        {
+            const double geo_minutes_per_meter = geo_distances_ratio_ * GetBusMultiplier() * GEO_BOUND_SAFETY;
+            if (geo_minutes_per_meter == 0)
+                return {};
+
+            return [this, geo_minutes_per_meter](VertexId from, VertexId to)
+            {
+                // Расстояние по прямой не больше суммы перегонов пути (неравенство треугольника), а каждый
+                // перегон не короче geo_distances_ratio_ его длины по прямой, поэтому оценка допустима
+                return geo::ComputeHaversineDistance(vertex_coordinates_[from], vertex_coordinates_[to]) *
+                       geo_minutes_per_meter;
+            };
+        }
+
+        void TransportRouter::SetRouter(unique_ptr<RouterBase<double>> router_ptr)
+        {
+            router_ptr_ = move(router_ptr);
+        }
+
+        void TransportRouter::BuildRouter()
+        {
+            bounded_search_ = make_unique<LazyBoundedSearch>();
+            switch ((*routing_settings_).router_type)
+            {
+            case RouterType::ALL_PAIRS:
+                router_ptr_ = make_unique<Router<double>>(graph_);
+                break;
+            case RouterType::ALL_PAIRS_BLOCKED:
+                router_ptr_ = make_unique<Router<double>>(graph_, thread::hardware_concurrency());
+                break;
+            case RouterType::ALL_PAIRS_DIJKSTRA:
+            {
+                // Маршруты строятся только из вершин прибытия на остановки, их id чётные
+                vector<VertexId> sources;
+                sources.reserve(graph_.GetVertexCount() / 2);
+                for (VertexId vertex = 0; vertex < graph_.GetVertexCount(); vertex += 2)
+                    sources.push_back(vertex);
+                router_ptr_ = make_unique<Router<double>>(graph_, sources, thread::hardware_concurrency());
+                break;
+            }
+            case RouterType::ALL_PAIRS_COMPACT:
+                router_ptr_ = make_unique<CompactRouter<double>>(graph_);
+                break;
+            case RouterType::TREE_CACHE:
+                router_ptr_ = make_unique<TreeCacheRouter<double>>(
+                    graph_, static_cast<size_t>(max((*routing_settings_).tree_cache_memory_mb, 0)) * 1024 * 1024);
+                break;
+            case RouterType::DIJKSTRA:
+                router_ptr_ = make_unique<DijkstraRouter<double>>(graph_);
+                break;
+            case RouterType::CONTRACTION_HIERARCHIES:
+                router_ptr_ = make_unique<ContractionHierarchyRouter<double>>(graph_);
+                break;
+            case RouterType::ASTAR:
+                router_ptr_ = make_unique<AStarRouter<double>>(graph_, MakeGeoLowerBound(), 0);
+                break;
+            case RouterType::ALT:
+                router_ptr_ = make_unique<AStarRouter<double>>(
+                    graph_, MakeGeoLowerBound(), static_cast<size_t>(max((*routing_settings_).landmark_count, 0)));
+                break;
+            case RouterType::HUB_LABELS:
+                router_ptr_ = make_unique<HubLabelRouter<double>>(graph_);
+                break;
+            case RouterType::RAPTOR:
+                // RAPTOR строится в FillDataToGraph по маршрутам автобусов, граф ему не нужен
+                router_ptr_.reset();
+                break;
+            }
+        }
+
+        RouteItem TransportRouter::MakeRouteItem(EdgeId edge_id) const
+        {
+            const EdgeSource &edge_source = edge_sources_[edge_id];
+            return {edge_source.kind, edge_source.id, edge_source.span_count, graph_.GetEdge(edge_id).weight};
+        }
+
+        bool TransportRouter::BuildRoute(const Stop *start_stop, const Stop *end_stop, RouteResult &route) const
+        {
+            // Буфер рёбер найденного маршрута, переиспользуемый между запросами потока
+            thread_local vector<EdgeId> route_edges;
+
+            route.total_time = 0;
+            route.items.clear();
+
+            if (raptor_router_ptr_)
+                return raptor_router_ptr_->BuildRoute(start_stop, end_stop, route);
+
+            const VertexId from = GetStopVertex(start_stop);
+            const VertexId to = GetStopVertex(end_stop);
+            if (!component_labels_.MayReach(from, to))
+                return false;
+
+            const auto weight = router_ptr_->BuildRouteInto(from, to, route_edges);
+            if (!weight.has_value())
+                return false;
+
+            route.total_time = *weight;
+            if (route.total_time == 0)
+                return true;
+
+            for (const EdgeId edge_id : route_edges)
+                route.items.push_back(MakeRouteItem(edge_id));
+
+            return true;
+        }
+
+        template <typename BuildFunc>
+        bool TransportRouter::Explain(RouteExplanation &explanation, BuildFunc build) const
+        {
+            explanation = RouteExplanation{};
+            explanation.router = GetRouterTypeName((*routing_settings_).router_type);
+
+            bool found = false;
+            const auto start_time = chrono::steady_clock::now();
+            {
+                SearchStatsScope stats_scope(explanation.stats);
+                found = build();
+            }
+            const auto end_time = chrono::steady_clock::now();
+
+            // Без отметки маршрутизатора (разные компоненты, совпадающие остановки) всё время - поиск
+            const auto search_end_time = explanation.stats.search_finished.value_or(end_time);
+            explanation.search_ms = chrono::duration<double, milli>(search_end_time - start_time).count();
+            explanation.unpack_ms = chrono::duration<double, milli>(end_time - search_end_time).count();
+            return found;
+        }
+
+        bool TransportRouter::ExplainRoute(const Stop *start_stop, const Stop *end_stop, RouteResult &route,
+                                           RouteExplanation &explanation) const
+        {
+            return Explain(explanation, [&]()
+            {
+                return BuildRoute(start_stop, end_stop, route);
+            });
+        }
+
+        void TransportRouter::ExplainRoute(const geo::Coordinates &from, const vector<NearestStop> &from_stops,
+                                           const geo::Coordinates &to, const vector<NearestStop> &to_stops,
+                                           RouteResult &route, RouteExplanation &explanation) const
+        {
+            Explain(explanation, [&]()
+            {
+                BuildRoute(from, from_stops, to, to_stops, route);
+                return true;
+            });
+        }
+
+        optional<double> TransportRouter::GetRouteTime(const Stop *start_stop, const Stop *end_stop) const
+        {
+            if (raptor_router_ptr_)
+            {
+                RouteResult route;
+                if (!raptor_router_ptr_->BuildRoute(start_stop, end_stop, route))
+                    return nullopt;
+                return route.total_time;
+            }
+
+            const VertexId from = GetStopVertex(start_stop);
+            const VertexId to = GetStopVertex(end_stop);
+            if (!component_labels_.MayReach(from, to))
+                return nullopt;
+
+            return router_ptr_->GetRouteWeight(from, to);
+        }
+
+        void TransportRouter::BuildRoute(const geo::Coordinates &from, const vector<NearestStop> &from_stops,
+                                         const geo::Coordinates &to, const vector<NearestStop> &to_stops,
+                                         RouteResult &route) const
+        {
+            thread_local vector<EdgeId> route_edges;
+
+            route.items.clear();
+            route.total_time = GetWalkTime(geo::ComputeDistance(from, to));
+
+            // Лучшая пара остановок: индексы в from_stops и to_stops и время с пешими участками
+            optional<double> best_time;
+            size_t best_from = 0;
+            size_t best_to = 0;
+            RouteResult raptor_route;
+            if (raptor_router_ptr_)
+            {
+                // RAPTOR не принимает несколько источников, поэтому ищет из каждой начальной остановки
+                vector<const Stop *> end_stops;
+                end_stops.reserve(to_stops.size());
+                for (const NearestStop &nearest : to_stops)
+                    end_stops.push_back(nearest.stop);
+
+                for (size_t i = 0; i < from_stops.size(); ++i)
+                {
+                    auto routes = raptor_router_ptr_->BuildRoutesFrom(from_stops[i].stop, end_stops);
+                    for (size_t j = 0; j < routes.size(); ++j)
+                    {
+                        if (!routes[j])
+                            continue;
+                        const double time = GetWalkTime(from_stops[i].distance) + (*routes[j]).total_time +
+                                            GetWalkTime(to_stops[j].distance);
+                        if (!best_time || time < *best_time)
+                        {
+                            best_time = time;
+                            best_from = i;
+                            best_to = j;
+                            raptor_route = move(*routes[j]);
+                        }
+                    }
+                }
+            }
+            else
+            {
+                using Endpoint = RouterBase<double>::Endpoint;
+                vector<Endpoint> sources;
+                sources.reserve(from_stops.size());
+                for (const NearestStop &nearest : from_stops)
+                    sources.push_back({GetStopVertex(nearest.stop), GetWalkTime(nearest.distance)});
+                vector<Endpoint> targets;
+                targets.reserve(to_stops.size());
+                for (const NearestStop &nearest : to_stops)
+                    targets.push_back({GetStopVertex(nearest.stop), GetWalkTime(nearest.distance)});
+
+                if (const auto best = router_ptr_->BuildBestRoute(sources, targets, route_edges))
+                {
+                    best_time = (*best).weight;
+                    best_from = (*best).source_index;
+                    best_to = (*best).target_index;
+                }
+            }
+
+            if (!best_time || !(*best_time < route.total_time))
+            {
+                if (route.total_time > 0)
+                    route.items.push_back({RouteItemKind::WALK, NO_STOP_INDEX, 0, route.total_time});
+                return;
+            }
+
+            route.total_time = *best_time;
+            const NearestStop &from_stop = from_stops[best_from];
+            const NearestStop &to_stop = to_stops[best_to];
+            if (from_stop.distance > 0)
+                route.items.push_back({RouteItemKind::WALK, GetStopIndex(*from_stop.stop), 0,
+                                       GetWalkTime(from_stop.distance)});
+            if (raptor_router_ptr_)
+            {
+                route.items.insert(route.items.end(), raptor_route.items.begin(), raptor_route.items.end());
+            }
+            else
+            {
+                for (const EdgeId edge_id : route_edges)
+                    route.items.push_back(MakeRouteItem(edge_id));
+            }
+            if (to_stop.distance > 0)
+                route.items.push_back({RouteItemKind::WALK, GetStopIndex(*to_stop.stop), 0,
+                                       GetWalkTime(to_stop.distance)});
+        }
+
+        void TransportRouter::GetReachableStops(const Stop *start_stop, double max_time,
+                                                vector<ReachableStop> &stops) const
+        {
+            if (raptor_router_ptr_)
+            {
+                raptor_router_ptr_->GetReachableStops(start_stop, max_time, stops);
+                return;
+            }
+
+            call_once(bounded_search_->built, [this]()
+            {
+                bounded_search_->search_ptr = make_unique<BoundedSearch<double>>(graph_);
+            });
+
+            thread_local vector<BoundedSearch<double>::ReachedVertex> reached;
+            bounded_search_->search_ptr->Run(GetStopVertex(start_stop), max_time, reached);
+
+            // Остановке соответствует вершина прибытия с чётным id, вершины после ожидания пропускаются
+            stops.clear();
+            for (const auto &[vertex, time] : reached)
+            {
+                if (vertex % 2 == 0)
+                    stops.push_back({stops_by_position_[vertex / 2], time});
+            }
+        }
+
+        RouteMatrixData TransportRouter::GetRouteMatrix(const vector<const Stop *> &start_stops,
+                                                        const vector<const Stop *> &end_stops,
+                                                        bool with_items) const
+        {
+            RouteMatrixData res;
+            res.from_count = start_stops.size();
+            res.to_count = end_stops.size();
+            res.total_times.resize(res.from_count * res.to_count);
+            if (with_items)
+                res.items.resize(res.total_times.size());
+
+            // Строки пишут в непересекающиеся ячейки результата
+            ParallelFor(start_stops.size(), thread::hardware_concurrency(), [&](size_t row)
+            {
+                if (!start_stops[row])
+                    return;
+
+                const size_t row_offset = row * res.to_count;
+                if (raptor_router_ptr_)
+                {
+                    auto routes = raptor_router_ptr_->BuildRoutesFrom(start_stops[row], end_stops);
+                    for (size_t column = 0; column < routes.size(); ++column)
+                    {
+                        if (!routes[column])
+                            continue;
+                        res.total_times[row_offset + column] = (*routes[column]).total_time;
+                        if (with_items)
+                            res.items[row_offset + column] = move((*routes[column]).items);
+                    }
+                    return;
+                }
+
+                // Заведомо недостижимые остановки не передаются в поиск, чтобы он не исчерпывал компоненту
+                const VertexId from = GetStopVertex(start_stops[row]);
+                vector<VertexId> targets;
+                vector<size_t> target_columns;
+                for (size_t column = 0; column < end_stops.size(); ++column)
+                {
+                    if (!end_stops[column])
+                        continue;
+                    const VertexId to = GetStopVertex(end_stops[column]);
+                    if (component_labels_.MayReach(from, to))
+                    {
+                        targets.push_back(to);
+                        target_columns.push_back(column);
+                    }
+                }
+                // Вся строка заведомо недостижима: ответ без поиска и без построения дерева
+                if (targets.empty())
+                    return;
+
+                const auto routes = router_ptr_->BuildRoutesFrom(from, targets);
+                for (size_t i = 0; i < routes.size(); ++i)
+                {
+                    if (!routes[i])
+                        continue;
+                    const size_t cell = row_offset + target_columns[i];
+                    res.total_times[cell] = (*routes[i]).weight;
+                    if (with_items && (*routes[i]).weight != 0)
+                    {
+                        for (const EdgeId edge_id : (*routes[i]).edges)
+                            res.items[cell].push_back(MakeRouteItem(edge_id));
+                    }
+                }
+            });
 
             return res;
         }
@@ -3,93 +3,287 @@
 #include <optional>
 #include <unordered_map>
 #include <memory>
+#include <mutex>
 #include <deque>
+#include <string_view>
 
 #include "domain.h"
 #include "router.h"
+#include "compact_router.h"
+#include "dijkstra_router.h"
+#include "contraction_hierarchy_router.h"
+#include "tree_cache_router.h"
+#include "astar_router.h"
+#include "hub_label_router.h"
+#include "bounded_search.h"
+#include "graph_components.h"
+#include "raptor_router.h"
+#include "stop_locator.h"
 #include "transport_catalogue.h"
 
 constexpr double METERS_IN_KM = 1000;
 constexpr double MINUTES_IN_HOUR = 60;
+// Относительный запас географической оценки времени на погрешность округления
+constexpr double GEO_BOUND_SAFETY = 1 - 1e-9;
 namespace transport_catalogue
 {
     namespace router
     {
+        // Способ поиска маршрутов: ALL_PAIRS предрассчитывает таблицу всех пар вершин
+        // (ALL_PAIRS_BLOCKED - тот же расчёт плитками на всех ядрах, ALL_PAIRS_COMPACT - в компактной
+        // таблице с весами float, занимающей в 3-4 раза меньше памяти, ALL_PAIRS_DIJKSTRA - та же
+        // таблица, заполненная параллельными поисками Дейкстры из вершин остановок),
+        // DIJKSTRA ищет каждый маршрут отдельно и не требует памяти O(V^2),
+        // CONTRACTION_HIERARCHIES один раз строит иерархию сжатий и отвечает двунаправленным поиском,
+        // TREE_CACHE кэширует деревья кратчайших путей из недавних начальных остановок,
+        // RAPTOR ищет по последовательностям остановок маршрутов, не строя граф,
+        // ASTAR направляет поиск к цели географической оценкой, ALT добавляет к ней оценки
+        // по ориентирам, расстояния до которых считаются при построении базы,
+        // HUB_LABELS хранит метки хабов и отвечает на запрос времени слиянием двух меток,
+        // а рёбра маршрута восстанавливает по рёбрам деревьев поиска, записанным в метках
+        enum class RouterType
+        {
+            ALL_PAIRS,
+            DIJKSTRA,
+            CONTRACTION_HIERARCHIES,
+            ALL_PAIRS_BLOCKED,
+            ALL_PAIRS_COMPACT,
+            TREE_CACHE,
+            RAPTOR,
+            ASTAR,
+            ALT,
+            ALL_PAIRS_DIJKSTRA,
+            HUB_LABELS,
+        };
+
+        RouterType ParseRouterType(std::string_view router_type);
+        std::string_view GetRouterTypeName(RouterType router_type);
+
+        // Порядок вершин графа: CATALOGUE - в порядке добавления остановок в справочник,
+        // RCM - обратный алгоритм Катхилла-Макки по соседству остановок на маршрутах,
+        // HILBERT - по кривой Гильберта через координаты остановок. Соседние по сети остановки
+        // получают близкие номера, и поиски с таблицами обращаются к соседним участкам памяти
+        enum class VertexOrder
+        {
+            CATALOGUE,
+            RCM,
+            HILBERT,
+        };
+
+        VertexOrder ParseVertexOrder(std::string_view vertex_order);
+
         struct RoutingSettings
         {
             double bus_velocity;
             double bus_wait_time;
+            RouterType router_type = RouterType::ALL_PAIRS;
+            // Ограничение памяти кэша деревьев для TREE_CACHE; отрицательное считается нулём
+            int tree_cache_memory_mb = 256;
+            // Число ориентиров для ALT; отрицательное считается нулём
+            int landmark_count = 8;
+            VertexOrder vertex_order = VertexOrder::CATALOGUE;
+            // Скорость пешехода в км/ч и число ближайших остановок у каждой точки для маршрутов
+            // между координатами
+            double walk_velocity = 5;
+            int nearest_stop_count = 3;
+        };
+
+        // Исходные данные ребра графа, хранятся в векторе по EdgeId. Вес получается из них
+        // по текущим настройкам маршрутизации, элемент ответа - по id без обращения к строкам
+        struct EdgeSource
+        {
+            RouteItemKind kind;
+            // Индекс остановки для ожидания или автобуса для поездки в справочнике
+            uint32_t id;
+            uint32_t span_count;
+            // Дорожное расстояние поездки в метрах, для ожидания - 0
+            double meters;
+        };
+
+        // Разбор одного запроса Route (explain): способ поиска, счётчики поиска и время в миллисекундах
+        // на поиск веса и на восстановление маршрута. У маршрутизаторов с готовыми таблицами поиск -
+        // это обращение к таблице, и счётчики остаются нулевыми
+        struct RouteExplanation
+        {
+            std::string_view router;
+            graph::SearchStats stats;
+            double search_ms = 0;
+            double unpack_ms = 0;
         };
 
         class TransportRouter
         {
         public:
+            using Graph = graph::DirectedWeightedGraph<double>;
+            using EdgeSources = std::vector<EdgeSource>;
+
             TransportRouter() = default;
 
             explicit TransportRouter(RoutingSettings &routing_settings);
 
+            // При уже построенном графе новые скорость и время ожидания пересчитывают веса рёбер
+            // на месте, затем перестраивается только маршрутизатор
             void SetOrUpdateRoutingSettings(RoutingSettings &settings);
 
             bool HasRoutingSettings() const;
 
+            // BuildGraph и затем BuildRouter
             void FillDataToGraph(const std::deque<Bus> &buses,
                                  const DictStopsPairToDistances &distances_map);
-            std::optional<PathData> GetShortWayBetween(Stop *start_stop, Stop *end_stop);
+            // Строит граф без маршрутизатора, чтобы время построения того и другого можно было
+            // измерить отдельно. Для RAPTOR графа нет, и здесь строятся его таблицы маршрутов
+            void BuildGraph(const std::deque<Bus> &buses,
+                            const DictStopsPairToDistances &distances_map);
+            // Заполняет переданный результат; при достаточной ёмкости его буфера память не выделяется.
+            // BuildRoute, GetRouteTime и GetRouteMatrix можно вызывать из нескольких потоков сразу:
+            // граф и маршрутизатор только читаются, а рабочие массивы поиска у каждого потока свои
+            bool BuildRoute(const Stop *start_stop, const Stop *end_stop, RouteResult &route) const;
+            // BuildRoute со сбором счётчиков и замером времени в explanation
+            bool ExplainRoute(const Stop *start_stop, const Stop *end_stop, RouteResult &route,
+                              RouteExplanation &explanation) const;
+            // Только время в пути без элементов маршрута
+            std::optional<double> GetRouteTime(const Stop *start_stop, const Stop *end_stop) const;
+            // Маршрут между точками: пешком до одной из ближайших к from остановок, на автобусах
+            // до одной из ближайших к to и пешком до to, либо пешком напрямую, если так быстрее.
+            // Лучшая пара остановок выбирается одним поиском сразу из всех from_stops
+            void BuildRoute(const geo::Coordinates &from, const std::vector<NearestStop> &from_stops,
+                            const geo::Coordinates &to, const std::vector<NearestStop> &to_stops,
+                            RouteResult &route) const;
+            // BuildRoute между точками со сбором счётчиков и замером времени в explanation
+            void ExplainRoute(const geo::Coordinates &from, const std::vector<NearestStop> &from_stops,
+                              const geo::Coordinates &to, const std::vector<NearestStop> &to_stops,
+                              RouteResult &route, RouteExplanation &explanation) const;
+            size_t GetNearestStopCount() const;
+            // Остановки, до которых можно добраться из start_stop не дольше чем за max_time минут,
+            // в порядке неубывания времени (запрос Reachable). Один ограниченный поиск по графу
+            void GetReachableStops(const Stop *start_stop, double max_time, std::vector<ReachableStop> &stops) const;
+            // Матрица маршрутов: один поиск на каждую начальную остановку, строки считаются
+            // параллельно. Отсутствующие остановки передаются как nullptr, маршрутов для них нет
+            RouteMatrixData GetRouteMatrix(const std::vector<const Stop *> &start_stops,
+                                           const std::vector<const Stop *> &end_stops,
+                                           bool with_items) const;
 
             size_t GetVertexAmount() const;
             void SetVertexAmount(size_t vertex_amount);
 
+            const Graph &GetGraph() const;
+            const EdgeSources &GetEdgeSources() const;
+            const graph::RouterBase<double> *GetRouter() const;
+
+            // Позиции остановок в порядке вершин по индексам справочника: остановке на позиции p
+            // соответствуют вершина прибытия 2 * p и вершина после ожидания 2 * p + 1
+            const std::vector<uint32_t> &GetStopPositions() const;
+
+            // Загружает ранее построенный граф без расчёта маршрутизатора. Маршрутизатор затем
+            // задаётся через SetRouter (он должен ссылаться на GetGraph()) или строится BuildRouter.
+            // Пустые позиции остановок означают порядок справочника
+            void LoadGraph(Graph graph, EdgeSources edge_sources, std::vector<uint32_t> stop_positions);
+            // Координаты вершин и нижняя граница времени на метр расстояния по прямой для ASTAR и ALT.
+            // Граница берётся по самому "прямому" перегону, поэтому оценка остаётся допустимой,
+            // даже если дорожное расстояние где-то меньше географического
+            void ComputeGeoLowerBound(const std::deque<Bus> &buses,
+                                      const DictStopsPairToDistances &distances_map);
+            graph::AStarRouter<double>::LowerBound MakeGeoLowerBound() const;
+            void SetRouter(std::unique_ptr<graph::RouterBase<double>> router_ptr);
+            void BuildRouter();
+
         private:
             std::optional<RoutingSettings> routing_settings_;
 
             size_t vertex_amount_ = 0;
-            graph::DirectedWeightedGraph<double> graph_;
-            std::unique_ptr<graph::Router<double>> router_ptr_;
+            Graph graph_;
+            std::unique_ptr<graph::RouterBase<double>> router_ptr_;
+            std::unique_ptr<RaptorRouter> raptor_router_ptr_;
+            // Метки компонент графа: пары остановок из разных частей сети отсекаются без поиска.
+            // Зависят только от рёбер, поэтому смена весов их не затрагивает
+            graph::ComponentLabels component_labels_;
+            // Ограниченный поиск строится по первому запросу Reachable (под call_once, так что
+            // одновременные запросы строят его один раз) и заменяется новым при любом изменении графа
+            struct LazyBoundedSearch
+            {
+                std::once_flag built;
+                std::unique_ptr<graph::BoundedSearch<double>> search_ptr;
+            };
+            std::unique_ptr<LazyBoundedSearch> bounded_search_ = std::make_unique<LazyBoundedSearch>();
+
+            EdgeSources edge_sources_;
+
+            // Индекс остановки в справочнике -> позиция в порядке вершин и обратно
+            std::vector<uint32_t> stop_positions_;
+            std::vector<uint32_t> stops_by_position_;
 
-            std::unordered_map<graph::EdgeId, PathDataItem> edge_id_to_path_data_;
+            std::vector<geo::Coordinates> vertex_coordinates_;
+            // Наименьшее отношение дорожного расстояния к географическому по всем перегонам
+            double geo_distances_ratio_ = 0;
+
+            double GetBusMultiplier() const;
+            double GetWalkTime(double meters) const;
+            double GetEdgeWeight(const EdgeSource &edge_source) const;
+            void ReweightGraph();
+            void ResetGraph();
+
+            // Остановки, упорядоченные по routing_settings_.vertex_order; остановки вне маршрутов
+            // идут в конце в порядке справочника
+            void ComputeStopPositions(const std::deque<Bus> &buses);
+            std::vector<uint32_t> MakeCuthillMcKeeOrder(const std::deque<Bus> &buses) const;
+            std::vector<uint32_t> MakeHilbertOrder(const std::deque<Bus> &buses) const;
+            void SetStopsOrder(std::vector<uint32_t> stops_by_position);
+            graph::VertexId GetStopVertex(const Stop *stop) const;
+
+            RouteItem MakeRouteItem(graph::EdgeId edge_id) const;
+
+            // Выполняет build() со сбором счётчиков поиска и замером времени в explanation
+            template <typename BuildFunc>
+            bool Explain(RouteExplanation &explanation, BuildFunc build) const;
+
+            // Ребро графа для пары вершин (from << 32 | to)
+            using ParallelEdges = std::unordered_map<uint64_t, graph::EdgeId>;
+
+            // Из параллельных рёбер между одной парой вершин в кратчайший путь попадает только
+            // самое короткое, поэтому хранится одно ребро на пару: более длинное отбрасывается,
+            // более короткое заменяет источник и вес ранее добавленного. При равной длине остаётся
+            // первое. Длина сравнивается в метрах, поэтому выбор не зависит от скорости автобуса
+            void AddEdge(graph::VertexId from, graph::VertexId to, const EdgeSource &edge_source,
+                         ParallelEdges &parallel_edges);
 
             template <typename It>
-            void AddBusToGraph(std::string_view bus_name,
+            void AddBusToGraph(uint32_t bus_index,
                                It b_stops, It e_stops,
-                               const DictStopsPairToDistances &distances_map)
+                               const DictStopsPairToDistances &distances_map,
+                               ParallelEdges &parallel_edges)
             {
-                const double bus_multiplier = 1.0 / METERS_IN_KM / (*routing_settings_).bus_velocity * MINUTES_IN_HOUR;
-                const double wait_multiplier = (*routing_settings_).bus_wait_time;
-
-                std::deque<double> weights;
+                std::deque<double> distances;
                 std::deque<graph::VertexId> after_waits_vertex_id;
                 for (auto it_stop = b_stops, it_next_stop = next(b_stops);
                      it_next_stop != e_stops;
                      ++it_stop, ++it_next_stop)
                 {
-                    edge_id_to_path_data_.emplace(
-                        graph_.AddEdge({(*it_stop)->id, (*it_stop)->id + 1,
-                                        wait_multiplier}),
-                        PathDataItemWait{(*it_stop)->name, wait_multiplier});
+                    const graph::VertexId stop_vertex = GetStopVertex(*it_stop);
+                    AddEdge(stop_vertex, stop_vertex + 1,
+                            {RouteItemKind::WAIT, GetStopIndex(**it_stop), 0, 0}, parallel_edges);
 
-                    after_waits_vertex_id.push_back((*it_stop)->id + 1);
+                    after_waits_vertex_id.push_back(stop_vertex + 1);
 
-                    double weight = 0;
+                    double distance = 0;
                     if (distances_map.count({*it_stop, *it_next_stop}) > 0)
-                        weight = distances_map.at({*it_stop, *it_next_stop}) * bus_multiplier;
+                        distance = distances_map.at({*it_stop, *it_next_stop});
                     else if (distances_map.count({*it_next_stop, *it_stop}) > 0)
-                        weight = distances_map.at({*it_next_stop, *it_stop}) * bus_multiplier;
-                    weights.push_back(weight);
+                        distance = distances_map.at({*it_next_stop, *it_stop});
+                    distances.push_back(distance);
 
                     int after_waits_vertex_size = after_waits_vertex_id.size();
                     for (int i = after_waits_vertex_size - 1; i >= 0; --i)
                     {
                         if (after_waits_vertex_size - i > 1)
                         {
-                            weights.push_back(weights[weights.size() - (after_waits_vertex_size - i - 1)] +
-                                              weights[weights.size() - after_waits_vertex_size]);
+                            distances.push_back(distances[distances.size() - (after_waits_vertex_size - i - 1)] +
+                                                distances[distances.size() - after_waits_vertex_size]);
                         }
 
-                        edge_id_to_path_data_.emplace(
-                            graph_.AddEdge({after_waits_vertex_id[i],
-                                            (*it_next_stop)->id,
-                                            weights.back()}),
-                            PathDataItemBus{bus_name, after_waits_vertex_size - i, weights.back()});
+                        AddEdge(after_waits_vertex_id[i], GetStopVertex(*it_next_stop),
+                                {RouteItemKind::BUS, bus_index,
+                                 static_cast<uint32_t>(after_waits_vertex_size - i), distances.back()},
+                                parallel_edges);
                     }
                 }
             }
@@ -0,0 +1,231 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Маршрутизатор, который по запросу строит полное дерево кратчайших путей из начальной
+// вершины и хранит последние деревья в LRU-кэше, ограниченном по памяти. Повторные
+// запросы из той же вершины восстанавливают путь по дереву за O(длины пути).
+template <typename Weight>
+class TreeCacheRouter : public RouterBase<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+    TreeCacheRouter(const Graph& graph, size_t memory_limit_bytes);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    std::optional<Weight> BuildRouteInto(VertexId from, VertexId to, std::vector<EdgeId>& edges) const override;
+    std::vector<std::optional<RouteInfo>> BuildRoutesFrom(VertexId from,
+                                                          const std::vector<VertexId>& targets) const override;
+
+    size_t GetCapacity() const;
+
+private:
+    static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+    static constexpr EdgeId UNREACHED = NO_EDGE - 1;
+
+    struct Tree {
+        std::vector<Weight> weights;
+        std::vector<EdgeId> prev_edges;
+    };
+    using TreePtr = std::shared_ptr<const Tree>;
+
+    TreePtr BuildTree(VertexId from) const;
+    TreePtr GetTree(VertexId from) const;
+    std::optional<Weight> ExtractRoute(const Tree& tree, VertexId to, std::vector<EdgeId>& edges) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+    CompressedGraph<Weight> compressed_graph_;
+    size_t capacity_;
+
+    mutable std::mutex cache_mutex_;
+    mutable std::list<std::pair<VertexId, TreePtr>> cache_;
+    mutable std::unordered_map<VertexId, typename std::list<std::pair<VertexId, TreePtr>>::iterator> cache_index_;
+};
+
+template <typename Weight>
+TreeCacheRouter<Weight>::TreeCacheRouter(const Graph& graph, size_t memory_limit_bytes)
+    : graph_(graph)
+    , compressed_graph_(graph)
+{
+    const size_t edge_count = graph.GetEdgeCount();
+    for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+
+    const size_t tree_bytes = std::max<size_t>(1, graph.GetVertexCount() * (sizeof(Weight) + sizeof(EdgeId)));
+    capacity_ = std::max<size_t>(1, memory_limit_bytes / tree_bytes);
+}
+
+template <typename Weight>
+size_t TreeCacheRouter<Weight>::GetCapacity() const {
+    return capacity_;
+}
+
+template <typename Weight>
+typename TreeCacheRouter<Weight>::TreePtr TreeCacheRouter<Weight>::BuildTree(VertexId from) const {
+    const size_t vertex_count = compressed_graph_.GetVertexCount();
+    auto tree = std::make_shared<Tree>();
+    tree->weights.assign(vertex_count, ZERO_WEIGHT);
+    tree->prev_edges.assign(vertex_count, UNREACHED);
+    std::vector<bool> settled(vertex_count, false);
+
+    RadixHeap<Weight> queue;
+    SearchStats* const stats = GetThreadSearchStats();
+    tree->prev_edges[from] = NO_EDGE;
+    queue.Push(ZERO_WEIGHT, from);
+    if (stats) {
+        ++stats->heap_pushes;
+    }
+
+    while (!queue.IsEmpty()) {
+        const auto [weight, vertex] = queue.Pop();
+        if (stats) {
+            ++stats->heap_pops;
+        }
+        if (settled[vertex]) {
+            continue;
+        }
+        settled[vertex] = true;
+
+        const size_t edges_begin = compressed_graph_.GetFirstEdge(vertex);
+        const size_t edges_end = compressed_graph_.GetFirstEdge(vertex + 1);
+        if (stats) {
+            ++stats->settled_vertices;
+            stats->relaxed_edges += edges_end - edges_begin;
+        }
+        for (size_t position = edges_begin; position < edges_end; ++position) {
+            const VertexId target = compressed_graph_.GetEdgeTarget(position);
+            const Weight candidate_weight = weight + compressed_graph_.GetEdgeWeight(position);
+            if (tree->prev_edges[target] == UNREACHED || candidate_weight < tree->weights[target]) {
+                tree->weights[target] = candidate_weight;
+                tree->prev_edges[target] = compressed_graph_.GetEdgeId(position);
+                queue.Push(candidate_weight, target);
+                if (stats) {
+                    ++stats->heap_pushes;
+                }
+            }
+        }
+    }
+
+    return tree;
+}
+
+template <typename Weight>
+typename TreeCacheRouter<Weight>::TreePtr TreeCacheRouter<Weight>::GetTree(VertexId from) const {
+    SearchStats* const stats = GetThreadSearchStats();
+    {
+        std::lock_guard guard(cache_mutex_);
+        if (const auto it = cache_index_.find(from); it != cache_index_.end()) {
+            cache_.splice(cache_.begin(), cache_, it->second);
+            if (stats) {
+                ++stats->cache_hits;
+            }
+            return it->second->second;
+        }
+    }
+    if (stats) {
+        ++stats->cache_misses;
+    }
+
+    // Дерево строится вне блокировки, чтобы не задерживать запросы из других вершин
+    TreePtr tree = BuildTree(from);
+
+    std::lock_guard guard(cache_mutex_);
+    if (const auto it = cache_index_.find(from); it != cache_index_.end()) {
+        cache_.splice(cache_.begin(), cache_, it->second);
+        return it->second->second;
+    }
+    cache_.emplace_front(from, tree);
+    cache_index_[from] = cache_.begin();
+    while (cache_.size() > capacity_) {
+        cache_index_.erase(cache_.back().first);
+        cache_.pop_back();
+    }
+    return tree;
+}
+
+template <typename Weight>
+std::optional<Weight> TreeCacheRouter<Weight>::ExtractRoute(const Tree& tree, VertexId to,
+                                                            std::vector<EdgeId>& edges) const {
+    if (to >= compressed_graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (tree.prev_edges[to] == UNREACHED) {
+        return std::nullopt;
+    }
+
+    edges.clear();
+    for (EdgeId edge_id = tree.prev_edges[to];
+         edge_id != NO_EDGE;
+         edge_id = tree.prev_edges[graph_.GetEdge(edge_id).from])
+    {
+        edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return tree.weights[to];
+}
+
+template <typename Weight>
+std::optional<Weight> TreeCacheRouter<Weight>::BuildRouteInto(VertexId from, VertexId to,
+                                                              std::vector<EdgeId>& edges) const {
+    if (from >= compressed_graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    const TreePtr tree = GetTree(from);
+    MarkSearchFinished(GetThreadSearchStats());
+    return ExtractRoute(*tree, to, edges);
+}
+
+template <typename Weight>
+std::optional<typename TreeCacheRouter<Weight>::RouteInfo> TreeCacheRouter<Weight>::BuildRoute(
+    VertexId from, VertexId to) const {
+    std::vector<EdgeId> edges;
+    const auto weight = BuildRouteInto(from, to, edges);
+    if (!weight) {
+        return std::nullopt;
+    }
+    return RouteInfo{*weight, std::move(edges)};
+}
+
+template <typename Weight>
+std::vector<std::optional<typename TreeCacheRouter<Weight>::RouteInfo>> TreeCacheRouter<Weight>::BuildRoutesFrom(
+    VertexId from, const std::vector<VertexId>& targets) const {
+    if (from >= compressed_graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    // Дерево из from строится или берётся из кэша один раз на все цели
+    const TreePtr tree = GetTree(from);
+    std::vector<std::optional<RouteInfo>> routes;
+    routes.reserve(targets.size());
+    for (const VertexId to : targets) {
+        std::vector<EdgeId> edges;
+        const auto weight = ExtractRoute(*tree, to, edges);
+        routes.push_back(weight ? std::optional<RouteInfo>(RouteInfo{*weight, std::move(edges)}) : std::nullopt);
+    }
+    return routes;
+}
+
+}  // namespace graph